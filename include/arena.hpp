@@ -0,0 +1,71 @@
+#ifndef __ARENA__
+    #define __ARENA__
+
+    #include "utils.hpp"
+
+    /* reference counted block of bytes, recycled by the arena once released */
+    struct Buffer
+    {
+        void* data;
+        size_t size;
+        int refs;
+    };
+
+    /*
+     * Pool of cost tensor and leader buffers. Each depth of the tree has its own tensor and
+     * leader sizes, hence its own free lists: once every depth has been reached, the
+     * exploration only recycles buffers instead of allocating them.
+     * Buffers are acquired and released by the exploration thread only.
+     */
+    class Arena
+    {
+        private:
+
+            struct SizeClass
+            {
+                size_t size;
+                vector<Buffer*> free_buffers;
+
+                // buffers preallocated by Reserve, kept by Trim
+                size_t reserved{0};
+            };
+
+            static vector<SizeClass> classes;
+            static bool huge_pages;
+            static double nb_allocations;
+            static double nb_reuses;
+            static size_t nb_bytes;
+            static double nb_node_states;
+
+            static SizeClass& Class (size_t size);
+
+        public:
+
+            static Buffer* Acquire (size_t size);
+
+            static void Share (Buffer* buf) { ++ buf->refs; }
+
+            static void Release (Buffer* buf);
+
+            static void Reserve (int n, int m, int depth, size_t entry_size);
+
+            static void Clear ();
+
+            // frees the buffers beyond the reserved ones
+            static void Trim ();
+
+            static void UseHugePages (bool enable) { huge_pages = enable; }
+
+            static double get_allocations () { return nb_allocations; }
+            static double get_reuses () { return nb_reuses; }
+
+            // bytes currently allocated, buffers in use and free buffers alike
+            static size_t get_bytes () { return nb_bytes; }
+
+            // heap allocations left to the nodes themselves: the mapping and the availability of
+            // each node built by a decomposition or a replay, everything else being recycled
+            static void CountNodeStates (int nb) { nb_node_states += 2*nb; }
+            static double get_nodeStates () { return nb_node_states; }
+    };
+
+#endif
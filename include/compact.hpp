@@ -0,0 +1,70 @@
+#ifndef __COMPACT__
+    #define __COMPACT__
+
+    #include "node.hpp"
+
+    const int MAX_QUBITS = 64;
+
+    /*
+     * Pool entry without cost matrix: path[d] is the physical qubit assigned at depth d to the
+     * logical qubit priority[d], and bit j of available is set while P_j is free. The cost matrix
+     * is rebuilt on demand by replaying the reductions from a cached ancestor.
+     */
+    struct CompactNode
+    {
+        uint64_t available;
+        int lower_bound;
+        uint8_t size;
+        uint8_t path[MAX_QUBITS];
+
+        bool isLeaf (int n) const { return n == size; }
+
+        vector<int> mapping (const vector<int>& priority, int n) const;
+
+        static CompactNode Root (int m);
+
+        // binary format of the spill files
+        static void WriteSegment (FILE* file, const CompactNode* nodes, size_t count);
+        static vector<CompactNode> ReadSegment (FILE* file);
+    };
+
+    /*
+     * Bounded cost matrices of the last decomposed node at each depth, with their lower bounds.
+     * In depth-first order the parent of a popped node is always cached, its matrix being reduced
+     * once; otherwise the deepest cached ancestor gets reduced along the remaining path.
+     */
+    template <typename T>
+    class ReplayCache
+    {
+        private:
+
+            const vector<int>& priority;
+            int n;
+            int m;
+
+            vector<CompactNode> ancestors;
+            vector<CostMatrix<T>> matrices;
+            vector<int> lower_bounds;
+            vector<bool> cached;
+
+            double nb_replays{0};
+
+        public:
+
+            ReplayCache (CostMatrix<T>&& root, const vector<int>& priority, int n, int m);
+
+            void store (const CompactNode& node, CostMatrix<T>&& CM, int lb);
+
+            const CostMatrix<T>& get_costMatrix (int depth) const { return matrices[depth]; }
+
+            Node<T> replay (const CompactNode& node);
+
+            double get_replays () const { return nb_replays; }
+    };
+
+    // children replace the content of the caller's vector, whose capacity gets reused
+    template <typename T>
+    void CompactChildren (const BoundingOptions& options, const CompactNode& node, const CostMatrix<T>& CM, int lb, const vector<int>& priority,
+                          int n, int m, int min_cost, vector<CompactNode>& children);
+
+#endif
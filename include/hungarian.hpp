@@ -3,6 +3,86 @@
 
     #include "utils.hpp"
 
-    int Hungarian (int* C, int i0, int j0, int n);
+    /*
+     * Hungarian algorithm with preallocated scratch buffers, grown to the largest m solved so
+     * far. Each thread owns one solver per cost type, so the bounding procedure solves its
+     * LAPs without touching the allocator. The solver runs its AVX-512 or AVX2 version when
+     * the CPU supports it, with bit-identical results.
+     */
+    template <typename T>
+    class HungarianSolver
+    {
+        private:
+
+            vector<int> job;
+            vector<T> prv;
+            vector<T> yw;
+            vector<T> yj;
+            vector<T> min_to;
+            vector<T> in_Z;
+            vector<int> Z;
+
+            void reserve (int n, int m);
+
+        public:
+
+            /*
+             * With assign, the solve is warm started: rows keep their previous column assign[w]
+             * while it stays a row minimum, the other rows being augmented from row reduced
+             * potentials, and assign receives the new assignment. The optimal cost is the same,
+             * the reduced costs may differ from a cold solve.
+             * The solve stops as soon as the optimal cost is known to exceed threshold, and then
+             * returns a value above threshold and leaves C untouched.
+             */
+            T solve (T* C, int n, int m, int* assign = nullptr, T threshold = std::numeric_limits<T>::max());
+
+            // solver of the calling thread
+            static HungarianSolver& Local ();
+    };
+
+    /*
+     * Lockstep Hungarian algorithm over up to LANES same-sized LAPs, held in a structure of
+     * arrays where entry x of problem b lies at x*LANES + b. Each step advances the shortest
+     * path search of every problem at once, the scans over the jobs running across the
+     * problems, so that short rows still fill the vector lanes. Problems that finish early
+     * idle until the last one completes. Results are bit-identical to HungarianSolver, which
+     * solves the blocks one by one on CPUs without AVX2 gathers.
+     */
+    template <typename T>
+    class BatchHungarian
+    {
+        private:
+
+            // int16_t problems run in 32-bit lanes, there being no 16-bit gathers
+            using G = typename std::conditional<(sizeof(T) < 4), int32_t, T>::type;
+
+            vector<G> costs;
+            vector<int> job;
+            vector<G> prv;
+            vector<G> yw;
+            vector<G> yj;
+            vector<G> min_to;
+            vector<G> in_Z;
+            vector<int> Z;
+
+            void reserve (int n, int m);
+
+        public:
+
+            static constexpr int LANES = 16;
+
+            /*
+             * Solves the nb_blocks <= LANES n×m LAPs at C + blocks[b]*block_size in place, as
+             * Hungarian does, and writes their optimal costs to opt[blocks[b]]. The LAPs are
+             * warm started from assign + blocks[b]*n as HungarianSolver does.
+             */
+            void solve (T* C, int block_size, const int* blocks, int nb_blocks, int n, int m, T* opt, int* assign = nullptr);
+
+            // solver of the calling thread
+            static BatchHungarian& Local ();
+    };
+
+    template <typename T>
+    T Hungarian (T* C, int n, int m);
 
 #endif
@@ -0,0 +1,88 @@
+#ifndef __KERNELS__
+    #define __KERNELS__
+
+    #include "utils.hpp"
+
+    /*
+     * SIMD-friendly building blocks of the bounding procedure. Each kernel is compiled for
+     * AVX2 and for the baseline instruction set, the AVX2 version being selected at runtime
+     * when the CPU supports it. Both versions give bit-identical results.
+     */
+
+    #if defined(__x86_64__) || defined(__i386__)
+        #define KERNELS_AVX2 1
+        #define KERNELS_AVX512 1
+    #endif
+
+    bool UseAVX2 ();
+
+    // AVX-512 foundation and byte/word instructions, the latter being needed for int16_t costs
+    bool UseAVX512 ();
+
+    /*
+     * Kernels are also specialized at compile time on the size of small subproblems, up to
+     * SMALL_SIZE, their loops then having constant trip counts. DispatchSize calls f with
+     * std::integral_constant<int, size> when 1 <= size <= S, and with the constant 0 of the
+     * generic version otherwise.
+     */
+    const int SMALL_SIZE = 12;
+
+    template <int S = SMALL_SIZE, typename F>
+    inline auto DispatchSize (int size, F&& f)
+    {
+        if constexpr (S == 0)
+            return f(std::integral_constant<int, 0>());
+        else
+            return (size == S) ? f(std::integral_constant<int, S>()) : DispatchSize<S - 1>(size, std::forward<F>(f));
+    }
+
+    /* true if the size entries of block are all zero */
+    template <typename T>
+    bool IsZeroBlock (const T* block, int size);
+
+    /* row r of the nb_rows×row_len block gets vals[r] added to each of its entries */
+    template <typename T>
+    void AddRowValues (T* block, const T* vals, int nb_rows, int row_len);
+
+    /*
+     * Halves the complementary costs of the row pair (i, k), i < k, of the n×m compact tensor C:
+     * for all j != l, C_ij[k][l] and C_kl[i][j] are both set to half their sum, the odd unit
+     * going to the first one if i + j + k + l is even and to the second one otherwise.
+     * tmp must hold m - 1 entries.
+     */
+    template <typename T>
+    void HalveRowPair (T* C, int n, int m, int i, int k, T* tmp);
+
+    /*
+     * Same as HalveRowPair, the rows of the pair first receiving their share of the leaders
+     * L_ij and L_kl as distributeLeader would spread them. L is left untouched, n > 1 and
+     * tmp must hold 2m entries.
+     */
+    template <typename T>
+    void DistributeHalveRowPair (T* C, const T* L, int n, int m, int i, int k, T* tmp);
+
+    /*
+     * Reduced-cost fixing of the row pair (i, k), i < k, of the n×m compact tensor C of a node
+     * bounded at lb, gap = min_cost - lb: when L_ij + L_kl + C_ij[k][l] + C_kl[i][j] > gap, no
+     * solution within min_cost assigns both q_i to P_j and q_k to P_l, and both entries are
+     * raised to FixingValue so that the next block LAPs see it. Returns the entries raised.
+     */
+    template <typename T>
+    int FixRowPair (T* C, const T* L, int n, int m, int i, int k, int64_t gap);
+
+    /*
+     * Same test on the leader alone: L_ij > gap rules P_j out for q_i, and L_ij is set to
+     * gap + 1, which still proves it while keeping the leader within the range of the costs.
+     * Returns the entries ruled out.
+     */
+    template <typename T>
+    int FixLeader (T* L, int n, int m, int64_t gap);
+
+    /* gap + 1, capped so that the raised entries of an n-row tensor cannot overflow T */
+    template <typename T>
+    inline T FixingValue (int64_t gap, int n)
+    {
+        return static_cast<T>(std::min<int64_t>(gap + 1, std::numeric_limits<T>::max() / (4*n*n)));
+    }
+
+#endif
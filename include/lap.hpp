@@ -0,0 +1,142 @@
+#ifndef __LAP__
+    #define __LAP__
+
+    #include "hungarian.hpp"
+
+    enum class LAPBackend { Hungarian, JonkerVolgenant, Auction };
+
+    /*
+     * Jonker-Volgenant algorithm: column reduction, reduction transfer and two augmenting row
+     * reduction passes give a partial assignment, completed by shortest augmenting paths.
+     * As Hungarian does, it leaves the reduced costs in C and returns the optimal cost, the
+     * reduced costs being the ones of other optimal potentials. An n×m LAP, n < m, starts from
+     * the row minima instead and goes straight to the augmenting paths: the columns' potentials
+     * start at 0 and only decrease once assigned, so that the columns left free keep a zero
+     * potential and the potentials stay close to the Hungarian ones.
+     */
+    template <typename T>
+    class JVSolver
+    {
+        private:
+
+            vector<int64_t> costs;
+            vector<int64_t> v;
+            vector<int64_t> d;
+            vector<int> rowsol;
+            vector<int> colsol;
+            vector<int> free_rows;
+            vector<int> collist;
+            vector<int> pred;
+            vector<int> matches;
+
+            void reserve (int n, int m);
+
+            // copy of C in the wide potentials type
+            void load (const T* C, int n, int m);
+
+            // shortest augmenting paths from the nb_free rows of free_rows
+            void augment (int m, int nb_free);
+
+            // reduced costs written back to C, and optimal cost
+            T reduce (T* C, int n, int m);
+
+        public:
+
+            T solve (T* C, int n, int m);
+
+            /*
+             * Same result from the potentials -prices[j] of the columns and a tentative
+             * assignment of the n rows to distinct columns, -1 for none: the edges left tight
+             * by the potentials are kept and the other rows augmented, the columns left free
+             * getting a zero potential.
+             */
+            T complete (T* C, int n, int m, const int64_t* prices, const int* assignment);
+
+            // solver of the calling thread
+            static JVSolver& Local ();
+    };
+
+    /*
+     * Forward auction algorithm with epsilon scaling over the costs scaled by m + 1, the last
+     * phase with epsilon = 1 giving an optimal assignment. The bids of a round are computed
+     * in parallel when the problem has at least PARALLEL_SIZE columns and the caller is not
+     * already in a parallel region. An n×m LAP, n < m, is padded with m - n zero rows.
+     * JVSolver then completes the assignment of the n rows from the prices rounded to the
+     * original units, which gives exact reduced costs.
+     */
+    template <typename T>
+    class AuctionSolver
+    {
+        private:
+
+            vector<int64_t> prices;
+            vector<int64_t> potentials;
+            vector<int> owner;
+            vector<int> assignment;
+            vector<int> unassigned;
+            vector<int> next_unassigned;
+            vector<int> bid_object;
+            vector<int64_t> bid_price;
+            vector<int> winner;
+
+            void reserve (int m);
+
+        public:
+
+            static const int PARALLEL_SIZE = 64;
+
+            T solve (T* C, int n, int m);
+
+            // solver of the calling thread
+            static AuctionSolver& Local ();
+    };
+
+    /*
+     * LAP backends of the bounding procedure, one for the blocks and one for the leader,
+     * the Hungarian algorithm by default. They are set once before the exploration.
+     */
+    class LAP
+    {
+        private:
+
+            static LAPBackend blocks;
+            static LAPBackend leader;
+
+            static double nb_block_laps;
+            static double nb_zero_blocks;
+            static double nb_aborted;
+
+        public:
+
+            static void UseBackends (LAPBackend blocks_lap, LAPBackend leader_lap) { blocks = blocks_lap; leader = leader_lap; }
+
+            static LAPBackend get_blocks () { return blocks; }
+            static LAPBackend get_leader () { return leader; }
+
+            // block LAPs solved and all-zero blocks skipped by the bounding procedure
+            static void CountBlocks (int nb_solved, int nb_skipped);
+
+            static double get_blockLAPs () { return nb_block_laps; }
+            static double get_zeroBlocks () { return nb_zero_blocks; }
+
+            // leader LAPs stopped early by SolveLeader
+            static double get_aborted () { return nb_aborted; }
+
+            // hungarian, jv or auction
+            static LAPBackend Parse (const string& name);
+            static string Name (LAPBackend backend);
+
+            // solves the n×m LAP C in place with the given backend, as Hungarian does
+            template <typename T>
+            static T Solve (LAPBackend backend, T* C, int n, int m);
+
+            /*
+             * Solves the leader C with the leader backend, a node bounded at lb being pruned once
+             * its cost exceeds gap = min_cost - lb: the Hungarian backend then stops as soon as its
+             * dual objective proves it, returns a cost above gap and leaves C untouched.
+             */
+            template <typename T>
+            static T SolveLeader (T* C, int n, int m, int64_t gap);
+    };
+
+#endif
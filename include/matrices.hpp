@@ -1,62 +1,163 @@
 #ifndef __MATRICES__
-    #define __MATRICES__ 
+    #define __MATRICES__
 
-    #include "utils.hpp"
+    #include "arena.hpp"
 
-    
+
+    /* T is the cost element type: int16_t, int32_t or int64_t */
+    template <typename T>
     class CostMatrix
     {
         private:
 
-            vector<int> costs;
-            vector<int> leader;
-            int size;
+            // arena buffers, the block tensor being possibly shared with the children viewing it
+            Buffer* costs{nullptr};
+            Buffer* leader{nullptr};
+            int rows{0};   // remaining logical qubits
+            int cols{0};   // remaining physical qubits
+
+            // a view only refers to the (rows+1)×(cols+1) tensor of its parent, reduced by row
+            // view_i and column view_j, until it is materialized into its own dense tensor
+            int view_i{-1};
+            int view_j{-1};
+
+            // optional warm start of the block LAPs: column assigned to each local row of each block
+            // by its last solve, -1 if none, following the tensor through views and reductions
+            Buffer* assignment{nullptr};
+
+            // logical rows whose blocks are all zero without being scanned: the idle qubits of the
+            // assembled tensor, followed through the reductions until the tensor gets bounded
+            uint64_t zero_rows{0};
+
+            static void ReduceCosts (const T* C, int n, int m, int i, int j, T* C_new);
+            static void ReduceAssignment (const int* A, int n, int m, int i, int j, int* A_new);
 
         public:
 
             CostMatrix () = default;
 
-            CostMatrix (const vector<int>& costs0, const vector<int>& leader0, int n) : costs(costs0), leader(leader0), size(n) {}
+            CostMatrix (int n, int m) : costs(Arena::Acquire(TensorSize(n, m) * sizeof(T))), leader(Arena::Acquire(n*m * sizeof(T))), rows(n), cols(m) {}
+
+            CostMatrix (CostMatrix&& CM) noexcept : costs(CM.costs), leader(CM.leader), rows(CM.rows), cols(CM.cols), view_i(CM.view_i), view_j(CM.view_j),
+                                                    assignment(CM.assignment), zero_rows(CM.zero_rows)
+            {
+                CM.costs = nullptr;
+                CM.leader = nullptr;
+                CM.assignment = nullptr;
+            }
+
+            CostMatrix& operator= (CostMatrix&& CM) noexcept
+            {
+                if (this != &CM)
+                {
+                    Arena::Release(costs);
+                    Arena::Release(leader);
+                    Arena::Release(assignment);
+
+                    costs = CM.costs;
+                    leader = CM.leader;
+                    rows = CM.rows;
+                    cols = CM.cols;
+                    view_i = CM.view_i;
+                    view_j = CM.view_j;
+                    assignment = CM.assignment;
+                    zero_rows = CM.zero_rows;
+
+                    CM.costs = nullptr;
+                    CM.leader = nullptr;
+                    CM.assignment = nullptr;
+                }
+                return *this;
+            }
+
+            // cost matrices are only moved, copies have to be explicit
+            CostMatrix (const CostMatrix&) = delete;
+            CostMatrix& operator= (const CostMatrix&) = delete;
+
+            ~ CostMatrix ()
+            {
+                Arena::Release(costs);
+                Arena::Release(leader);
+                Arena::Release(assignment);
+            }
+
+            const T* get_costs () const { assert(!isView() && "Error: Cost matrix must be materialized."); return static_cast<const T*>(costs->data); }
+            T* get_costs () { assert(!isView() && "Error: Cost matrix must be materialized."); return static_cast<T*>(costs->data); }
+            const T* get_leader () const { return static_cast<const T*>(leader->data); }
+            T* get_leader () { return static_cast<T*>(leader->data); }
+            int* get_assignment () { assert(!isView() && "Error: Cost matrix must be materialized."); return assignment ? static_cast<int*>(assignment->data) : nullptr; }
+            int get_rows () const { return rows; }
+            int get_cols () const { return cols; }
+
+            // each block (i, j) only stores its (rows-1)×(cols-1) feasible entries
+            int get_blockSize () const { return (rows - 1)*(cols - 1); }
+
+            static int TensorSize (int n, int m) { return n*m*(n - 1)*(m - 1); }
+            static int AssignmentSize (int n, int m) { return n*m*(n - 1); }
+
+            bool isView () const { return view_i >= 0; }
+
+            // the flagged rows only hold zero blocks while the leader is zero, none otherwise
+            uint64_t get_zeroRows () const;
 
-            ~ CostMatrix () = default;
+            // the bounding refills the blocks of the idle rows through the leader and the halving
+            void clearZeroRows () { zero_rows = 0; }
 
-            const vector<int>& get_costs () const { return costs; }
-            vector<int>& get_costs () { return costs; }
-            const vector<int>& get_leader () const { return leader; }
-            vector<int>& get_leader () { return leader; }
-            int get_size () const { return size; }
+            // the block LAPs get warm started from their previous assignments, the children included
+            void initAssignment ();
+            bool hasAssignment () const { return assignment != nullptr; }
 
-            static CostMatrix Assemble (const vector<vector<int>>& D, const vector<vector<int>>& F, int n);
+            void materialize ();
+
+            CostMatrix clone () const;
+
+            static CostMatrix Assemble (const vector<vector<int>>& D, const vector<vector<int>>& F, int n, int m);
 
             void distributeLeader ();
-            void distributeLeader_OMP ();
 
             void halveComplementary ();
-            void halveComplementary_OMP ();
+
+            // reduced-cost fixing of a node bounded at lb, see FixRowPair, returns the entries fixed
+            int fixVariables (int lb, int min_cost);
 
             CostMatrix reduce (int i, int j) const;
 
+            // clones share their buffers until one of them gets materialized
+            bool sharesBuffers (const CostMatrix& CM) const { return costs != nullptr && costs == CM.costs && leader == CM.leader; }
+
+            bool isEmpty () const { return costs == nullptr; }
+
+            // binary format of the spill files, views being written as dense matrices
+            void write (FILE* file) const;
+            static CostMatrix Read (FILE* file);
+
             friend std::ostream& operator<<(std::ostream& os, const CostMatrix& CM)
             {
-                const int n = CM.size;
-                const auto& C = CM.costs;
-                const auto& L = CM.leader;
+                CostMatrix CM_dense = CM.clone();
+                CM_dense.materialize();
 
-                os << "Cost matrix (size = " << n << ")\n";
+                const int n = CM.rows;
+                const int m = CM.cols;
+                const T* C = CM_dense.get_costs();
+                const vector<T> L(CM.get_leader(), CM.get_leader() + n*m);
+
+                os << "Cost matrix (size = " << n << "x" << m << ")\n";
 
                 for (int i = 0; i < n; ++i)
                 {
                     for (int k = 0; k < n; ++k)
                     {
                         os << "[ ";
-                        for (int j = 0; j < n; ++j)
+                        for (int j = 0; j < m; ++j)
                         {
-                            for (int l = 0; l < n; ++l)
+                            for (int l = 0; l < m; ++l)
                             {
                                 if ((k == i) ^ (l == j))
                                     os << "* ";
+                                else if (k == i)
+                                    os << L[i*m + j] << " ";
                                 else
-                                    os << C[idx4D(i, j, k, l, n)] << " ";
+                                    os << C[idx4D(i, j, k, l, n, m)] << " ";
                             }
                             os << "| ";
                         }
@@ -65,7 +166,7 @@
                     if (i != n - 1)
                     {
                         os << "  ";
-                        for (int k = 0; k < n*n + n - 1; ++k)
+                        for (int k = 0; k < m*m + m - 1; ++k)
                             os << "- ";
                         os << "\n";
                     }
@@ -80,9 +181,46 @@
             template <class Archive>
             void serialize (Archive &ar, const unsigned int version)
             {
-                ar & costs;
-                ar & leader;
-                ar & size;
+                // views are sent as dense matrices, loading never overwrites a shared buffer
+                if (Archive::is_saving::value)
+                {
+                    materialize();
+
+                    vector<T> costs_buf(get_costs(), get_costs() + TensorSize(rows, cols));
+                    vector<T> leader_buf(get_leader(), get_leader() + rows*cols);
+                    vector<int> assignment_buf;
+
+                    if (hasAssignment())
+                        assignment_buf.assign(get_assignment(), get_assignment() + AssignmentSize(rows, cols));
+
+                    ar & rows;
+                    ar & cols;
+                    ar & costs_buf;
+                    ar & leader_buf;
+                    ar & assignment_buf;
+                }
+                else
+                {
+                    vector<T> costs_buf, leader_buf;
+                    vector<int> assignment_buf;
+
+                    ar & rows;
+                    ar & cols;
+                    ar & costs_buf;
+                    ar & leader_buf;
+                    ar & assignment_buf;
+
+                    *this = CostMatrix(rows, cols);
+
+                    std::copy(costs_buf.begin(), costs_buf.end(), get_costs());
+                    std::copy(leader_buf.begin(), leader_buf.end(), get_leader());
+
+                    if (!assignment_buf.empty())
+                    {
+                        initAssignment();
+                        std::copy(assignment_buf.begin(), assignment_buf.end(), get_assignment());
+                    }
+                }
             }
     };
 
@@ -92,4 +230,6 @@
 
     vector<vector<int>> LinearCouplingDistanceMatrix (int n);
 
+    int CostTypeBits (const vector<vector<int>>& D, const vector<vector<int>>& F, int n);
+
 #endif
@@ -17,6 +17,130 @@
         }
     };
 
+    /*
+     * Levels of the bound cascade, from the cheapest: the LAP of the leader alone, then the
+     * Gilmore-Lawler bound, the block LAPs added once to the leader without spreading it, and
+     * last the iterative bound, only run on the nodes that survived the cheaper levels.
+     */
+    enum class BoundLevel { Leader, GilmoreLawler, Iterative };
+
+    /*
+     * Choice of the logical qubit a node branches on: the next one in the static priority order,
+     * the one whose leader row has the largest gap between its two smallest reduced costs, or the
+     * one leaving the fewest children below the best cost. The dynamic rules read the leader of
+     * the bounded node, the priority order breaking their ties.
+     */
+    enum class Branching { Static, Regret, Fewest };
+
+    /*
+     * Options of the bounding procedure shared by all the nodes, parsed once and passed to the
+     * bounding and the decomposition.
+     * With fixing, each bounding iteration ends with the reduced-cost fixing of the node's tensor
+     * as long as the node is not pruned.
+     * The iterations of a node at depth d are budgeted by the schedule, its last budget holding
+     * for the deeper nodes, it_max being used without one. With early stops, they also end once
+     * an iteration gains less than min_gain times the gap left to min_cost, or with gap_stop once
+     * the last gain repeated over the rest of the budget could not prune the node.
+     * Ordered by bound, the children of a node are explored by increasing lower bound, the ties
+     * going to the physical qubit closest to the ones already taken, instead of by index.
+     */
+    struct BoundingOptions
+    {
+        bool fixing{false};
+
+        // cheap levels run before the iterative bound, none by default
+        vector<BoundLevel> cascade;
+
+        vector<int> schedule;
+        double min_gain{0};
+        bool gap_stop{false};
+
+        // by bound instead of by index, the distances giving the locality of the physical qubits
+        bool child_order{false};
+        vector<vector<int>> distances;
+
+        Branching branching{Branching::Static};
+
+        // options of the command line, D being kept for the child order by bound
+        static BoundingOptions Parse (int argc, char** argv, const vector<vector<int>>& D);
+
+        // names of the options read by Parse, for the drivers to accept them
+        static vector<string> OptionNames ();
+
+        // comma separated list of leader and glb, or none
+        static vector<BoundLevel> ParseCascade (const string& list);
+        static string Name (BoundLevel level);
+
+        // comma separated budgets from the root, or none
+        static vector<int> ParseSchedule (const string& list);
+
+        // index or bound
+        static bool ParseChildOrder (const string& name);
+
+        // static, regret or fewest
+        static Branching ParseBranching (const string& name);
+        static string Name (Branching rule);
+
+        int Budget (int it_max, int depth) const { return schedule.empty() ? it_max : schedule[std::min(depth, (int)schedule.size() - 1)]; }
+
+        // true if a node bounded at lb after gaining incre at iteration it of its budget should stop
+        bool StopIterating (int64_t incre, int lb, int min_cost, int it, int budget) const;
+
+        // available physical qubits whose lower bound lbs[j] does not exceed min_cost, in push
+        // order into order: the last one is explored first by a depth-first pool
+        void ChildOrder (const vector<int>& lbs, const vector<bool>& av, int min_cost, vector<int>& order) const;
+
+        // Boost serialization support
+        template <class Archive>
+        void serialize (Archive& ar, const unsigned int version)
+        {
+            ar & fixing;
+            ar & cascade;
+            ar & schedule;
+            ar & min_gain;
+            ar & gap_stop;
+            ar & child_order;
+            ar & distances;
+            ar & branching;
+        }
+    };
+
+    /* statistics of the bounding procedure, gathered over all the nodes */
+    class Bounding
+    {
+        private:
+
+            static double nb_fixed;
+
+            static double nb_tried[3];
+            static double nb_pruned[3];
+
+            static vector<double> nb_bounded;
+            static vector<double> nb_iterations;
+
+            static double nb_reordered;
+
+        public:
+
+            static void CountFixed (int count);
+            static double get_fixed () { return nb_fixed; }
+
+            // nodes bounded and pruned at each level
+            static void CountLevel (BoundLevel level, bool pruned);
+            static double get_tried (BoundLevel level) { return nb_tried[int(level)]; }
+            static double get_pruned (BoundLevel level) { return nb_pruned[int(level)]; }
+
+            // iterations run by the nodes bounded at each depth, counted outside of the parallel regions
+            static void CountIterations (int depth, int it);
+            static double get_bounded (int depth) { return (depth < (int)nb_bounded.size()) ? nb_bounded[depth] : 0; }
+            static double get_iterations (int depth) { return (depth < (int)nb_iterations.size()) ? nb_iterations[depth] : 0; }
+
+            // nodes branching on another logical qubit than the static order would
+            static void CountReordered () { ++nb_reordered; }
+            static double get_reordered () { return nb_reordered; }
+    };
+
+    template <typename T>
     class Node
     {
         private:
@@ -25,41 +149,83 @@
             //vector<int> solution;
             int size;
             int lower_bound;
-            CostMatrix costMatrix;
+            CostMatrix<T> costMatrix;
             vector<bool> available;
 
+            // a lazy child still holds its parent's cost matrix, only reduced by (branch_k, branch_l)
+            // once the child gets bounded, decomposed or sent
+            int branch_k{-1};
+            int branch_l{-1};
+
+            // bounded along with its siblings as soon as its parent got decomposed
+            bool bounded{false};
+
+            // runs the cheap levels of the cascade, true if one of them lifts the bound above min_cost
+            bool prefilter (const BoundingOptions& options, int min_cost, bool parallel);
+
         public:
 
             Node () = default;
 
             ~ Node () = default;
 
-            Node (Solution solution0, int size0, int lower_bound0, CostMatrix& costMatrix0, vector<bool> available0) : solution(solution0),
-                                                                                                                       size(size0),
-                                                                                                                       lower_bound(lower_bound0),
-                                                                                                                       costMatrix(costMatrix0),
-                                                                                                                       available(available0) {}
+            Node (Solution solution0, int size0, int lower_bound0, CostMatrix<T>&& costMatrix0, vector<bool> available0,
+                  int branch_k0 = -1, int branch_l0 = -1) : solution(std::move(solution0)),
+                                                            size(size0),
+                                                            lower_bound(lower_bound0),
+                                                            costMatrix(std::move(costMatrix0)),
+                                                            available(std::move(available0)),
+                                                            branch_k(branch_k0),
+                                                            branch_l(branch_l0) {}
+
+            // nodes own their cost matrix, they are moved and never copied
+            Node (Node&&) = default;
+            Node& operator= (Node&&) = default;
 
             const Solution& get_solution () const { return solution; }
             Solution& get_solution () { return solution; }
             int get_size () const { return size; }
             int get_lowerBound () const { return lower_bound; }
-            const CostMatrix& get_costMatrix () const { return costMatrix; }
-            CostMatrix& get_costMatrix () { return costMatrix; }
+            const CostMatrix<T>& get_costMatrix () const { return costMatrix; }
+            CostMatrix<T>& get_costMatrix () { return costMatrix; }
             const vector<bool>& get_available () const { return available; }
             vector<bool>& get_available () { return available; }
 
             bool isLeaf (int n) const { return n == size; }
 
-            int bound (int it_max, int min_cost, int& it, bool early_stop, double& rt);
-            int bound_OMP (int it_max, int min_cost, int& it, bool early_stop, double& rt);
+            bool isLazy () const { return branch_k >= 0; }
+
+            bool isBounded () const { return bounded; }
 
-            vector<Node> decompose (const vector<int>& priority, int n, int m, int min_cost);
+            void expand ();
+
+            int bound (const BoundingOptions& options, int it_max, int min_cost, int& it, bool early_stop, double& rt);
+            int bound_OMP (const BoundingOptions& options, int it_max, int min_cost, int& it, bool early_stop, double& rt);
+
+            // children replace the content of the caller's vector, whose capacity gets reused
+            void decompose (const BoundingOptions& options, const vector<int>& priority, int n, int m, int min_cost, vector<Node>& children);
+
+            /*
+             * Bounds the children of one decomposition together. The levels of the cascade run
+             * first, one sibling per thread, the pruned ones never getting their iterative bound.
+             * The others are bounded as bound_OMP would, their row pairs, blocks and leaders being
+             * scheduled as single worksharing loops over all of them, on one thread unless
+             * parallel. its[s] receives the iterations of sibling s, -1 for leaves.
+             */
+            static void BoundSiblings (const BoundingOptions& options, vector<Node>& siblings, int it_max, int min_cost, bool early_stop, bool parallel,
+                                       vector<int>& its, double& rt);
+
+            // binary format of the spill files, a cost matrix shared by lazy siblings being written once per segment
+            static void WriteSegment (FILE* file, const Node* nodes, size_t count);
+            static vector<Node> ReadSegment (FILE* file);
 
             // Boost serialization support
             template <class Archive>
             void serialize (Archive &ar, const unsigned int version)
             {
+                if (Archive::is_saving::value)
+                    expand();
+
                 ar & solution;
                 ar & size;
                 ar & lower_bound;
@@ -67,7 +233,7 @@
                 ar & available;
             }
 
-        static Node Root (const vector<vector<int>>& D, const vector<vector<int>>& F, int n, int m);
+        static Node Root (const vector<vector<int>>& D, const vector<vector<int>>& F, int n, int m, bool rectangular = false, bool warm_start = false);
     };
 
     double ComputeTotalNumberOfNodes (int n, int m);
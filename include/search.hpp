@@ -0,0 +1,75 @@
+#ifndef __SEARCH__
+    #define __SEARCH__
+
+    #include "spill.hpp"
+
+    #include <map>
+
+    enum class Strategy { DepthFirst, BestFirst, Hybrid };
+
+    // dfs, best or hybrid
+    Strategy ParseStrategy (const string& name);
+    string StrategyName (Strategy strategy);
+
+    /*
+     * Open nodes of type N explored with a selectable strategy. Depth-first nodes live on a
+     * SpillPool stack, best-first ones in a binary heap on their lower bound, the deeper node
+     * first on ties. The hybrid strategy dives depth-first and, every period pops, moves the
+     * open nodes of the dive to the heap and resumes from the best bound. While the arena
+     * buffers and the heap exceed queue_limit bytes, nodes stay on the stack instead: the
+     * search falls back to depth-first until the heap drains. The lower bounds of all the open
+     * nodes, spilled ones included, are counted so that the global lower bound is always known.
+     */
+    template <typename N>
+    class SearchPool
+    {
+        private:
+
+            Strategy strategy;
+            size_t queue_limit;
+            int period;
+
+            SpillPool<N> stack;
+            vector<N> heap;
+
+            // lower bounds of the open nodes, with their multiplicities
+            std::map<int, size_t> bounds;
+
+            // entries of the bounds no open node holds anymore, recycled instead of reallocated
+            vector<std::map<int, size_t>::node_type> spare_bounds;
+
+            size_t nb_pops{0};
+            double nb_fallbacks{0};
+
+            bool heapFull () const;
+
+            void pushHeap (N&& node);
+            N popHeap ();
+
+            // true if a is explored after b
+            static bool Worse (const N& a, const N& b);
+
+        public:
+
+            // no cap with queue_limit = 0, mem_limit being the budget of the stack
+            SearchPool (Strategy strategy, size_t mem_limit = 0, size_t queue_limit = 0, int period = 64);
+
+            bool empty () const { return stack.empty() && heap.empty(); }
+
+            size_t size () const { return stack.size() + heap.size(); }
+
+            void push (N&& node);
+
+            N pop ();
+
+            // smallest lower bound of the open nodes, INF if none
+            int get_lowerBound () const { return bounds.empty() ? INF : bounds.begin()->first; }
+
+            // nodes kept on the stack because of the cap
+            double get_fallbacks () const { return nb_fallbacks; }
+
+            double get_spills () const { return stack.get_spills(); }
+            double get_reloads () const { return stack.get_reloads(); }
+    };
+
+#endif
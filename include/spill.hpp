@@ -0,0 +1,62 @@
+#ifndef __SPILL__
+    #define __SPILL__
+
+    #include "node.hpp"
+    #include "compact.hpp"
+
+    /*
+     * Depth-first pool of nodes of type N under a memory budget. Once the arena buffers and the
+     * pool entries exceed mem_limit bytes, the bottom half of the in-memory nodes, i.e. the ones
+     * explored last, is written as a segment at the end of a temporary file. Segments are read
+     * back in reverse order once the in-memory nodes run out, which keeps the exploration order.
+     * N provides the static WriteSegment and ReadSegment of its binary format.
+     */
+    template <typename N>
+    class SpillPool
+    {
+        private:
+
+            vector<N> nodes;
+            size_t mem_limit;
+
+            FILE* file{nullptr};
+            vector<long> segments;      // file offsets of the segments, the last one at the end
+            long file_end{0};
+            size_t nb_spilled{0};
+
+            double nb_spills{0};
+            double nb_reloads{0};
+
+            // smallest number of nodes written in a segment
+            static const size_t MIN_SEGMENT = 16;
+
+            void spill ();
+            void reload ();
+
+        public:
+
+            // no budget with mem_limit = 0
+            explicit SpillPool (size_t mem_limit = 0) : mem_limit(mem_limit) {}
+            ~SpillPool ();
+
+            SpillPool (const SpillPool&) = delete;
+            SpillPool& operator= (const SpillPool&) = delete;
+
+            bool empty () const { return nodes.empty() && segments.empty(); }
+
+            // nodes in memory and on disk
+            size_t size () const { return nodes.size() + nb_spilled; }
+
+            void push_back (N&& node);
+
+            N& back ();
+            void pop_back ();
+
+            // moves out up to count in-memory nodes from the bottom of the pool
+            vector<N> split_bottom (size_t count);
+
+            double get_spills () const { return nb_spills; }
+            double get_reloads () const { return nb_reloads; }
+    };
+
+#endif
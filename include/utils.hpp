@@ -5,6 +5,7 @@
     #include <cassert>
     #include <limits>
     #include <vector>
+    #include <memory>
     #include <queue>
     #include <stack>
     #include <algorithm>
@@ -12,12 +13,44 @@
     #include <fstream>
     #include <string>
     #include <sstream>
+    #include <cstdint>
+    #include <cstdio>
     #include <omp.h>
 
     using namespace std;
 
     const int INF = std::numeric_limits<int>::max();
 
+    /* a + b, exiting instead of silently wrapping around when the sum overflows T */
+    template <typename T, typename U>
+    T CheckedAdd (T a, U b)
+    {
+        T sum;
+
+        if (__builtin_add_overflow(a, b, &sum))
+        {
+            std::cerr << "Error: cost overflow (" << +a << " + " << +b << "), use a wider cost type (--cost-type)" << std::endl;
+            exit(1);
+        }
+
+        return sum;
+    }
+
+    /* a * b converted to T, exiting when the product does not fit */
+    template <typename T>
+    T CheckedProduct (int a, int b)
+    {
+        T prod;
+
+        if (__builtin_mul_overflow(a, b, &prod))
+        {
+            std::cerr << "Error: cost overflow (" << a << " * " << b << "), use a wider cost type (--cost-type)" << std::endl;
+            exit(1);
+        }
+
+        return prod;
+    }
+
     /* overload operator << to display a 1D vector */
     template <typename T>
     std::ostream& operator<< (std::ostream& os, const vector<T>& vec)
@@ -45,6 +78,16 @@
 
     vector<int> Arange (int n);
 
-    int idx4D (int i, int j, int k, int l, int n);
+    int idx4D (int i, int j, int k, int l, int n, int m);
+
+    vector<string> PositionalArguments (int argc, char** argv);
+
+    string OptionalArgument (int argc, char** argv, const string& name, const string& default_value);
+
+    void CheckOptions (int argc, char** argv, const vector<string>& names);
+
+    void WriteBytes (FILE* file, const void* data, size_t bytes);
+
+    void ReadBytes (FILE* file, void* data, size_t bytes);
 
 #endif
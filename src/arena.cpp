@@ -0,0 +1,151 @@
+#include "../include/arena.hpp"
+
+#include <cstdlib>
+#ifdef __linux__
+    #include <sys/mman.h>
+#endif
+
+
+vector<Arena::SizeClass> Arena::classes;
+bool Arena::huge_pages = false;
+double Arena::nb_allocations = 0;
+double Arena::nb_reuses = 0;
+size_t Arena::nb_bytes = 0;
+double Arena::nb_node_states = 0;
+
+
+Arena::SizeClass& Arena::Class (size_t size)
+{
+    for (SizeClass& c : classes)
+    {
+        if (c.size == size)
+            return c;
+    }
+
+    classes.push_back(SizeClass{size, {}, 0});
+
+    return classes.back();
+}
+
+
+Buffer* Arena::Acquire (size_t size)
+{
+    SizeClass& c = Class(size);
+
+    if (!c.free_buffers.empty())
+    {
+        Buffer* buf = c.free_buffers.back();
+        c.free_buffers.pop_back();
+
+        buf->refs = 1;
+        ++ nb_reuses;
+
+        return buf;
+    }
+
+    ++ nb_allocations;
+
+    const size_t huge_page_size = 1 << 21;
+    const size_t alignment = 64;
+
+    size_t bytes = size;
+    void* ptr = nullptr;
+
+    if (huge_pages && bytes >= huge_page_size)
+    {
+        // round to whole huge pages and ask for transparent huge pages backing
+        bytes = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+
+        if (posix_memalign(&ptr, huge_page_size, bytes) != 0)
+            ptr = nullptr;
+        #ifdef MADV_HUGEPAGE
+        else
+            madvise(ptr, bytes, MADV_HUGEPAGE);
+        #endif
+    }
+    else if (bytes > 0)
+    {
+        bytes = (bytes + alignment - 1) / alignment * alignment;
+
+        ptr = std::aligned_alloc(alignment, bytes);
+    }
+
+    if (bytes > 0 && ptr == nullptr)
+    {
+        cerr << "Error: cannot allocate a buffer of " << bytes << " bytes" << endl;
+        exit(1);
+    }
+
+    nb_bytes += size;
+
+    return new Buffer{ptr, size, 1};
+}
+
+
+void Arena::Release (Buffer* buf)
+{
+    if (buf == nullptr || -- buf->refs > 0)
+        return;
+
+    Class(buf->size).free_buffers.push_back(buf);
+}
+
+
+/* preallocates one tensor and the leaders of one sibling group for each of the depths of
+   a tree whose root has n logical and m physical qubits */
+void Arena::Reserve (int n, int m, int depth, size_t entry_size)
+{
+    vector<Buffer*> reserved;
+
+    for (int d = 0; d < depth && d < n; ++d)
+    {
+        const int r = n - d;
+        const int c = m - d;
+
+        reserved.push_back(Acquire(r*c*(r - 1)*(c - 1) * entry_size));
+
+        for (int k = 0; k <= c; ++k)
+            reserved.push_back(Acquire(r*c * entry_size));
+    }
+
+    for (Buffer* buf : reserved)
+    {
+        ++ Class(buf->size).reserved;
+        Release(buf);
+    }
+}
+
+
+void Arena::Clear ()
+{
+    for (SizeClass& c : classes)
+    {
+        for (Buffer* buf : c.free_buffers)
+        {
+            nb_bytes -= buf->size;
+
+            std::free(buf->data);
+            delete buf;
+        }
+        c.free_buffers.clear();
+        c.reserved = 0;
+    }
+}
+
+
+void Arena::Trim ()
+{
+    for (SizeClass& c : classes)
+    {
+        while (c.free_buffers.size() > c.reserved)
+        {
+            Buffer* buf = c.free_buffers.back();
+            c.free_buffers.pop_back();
+
+            nb_bytes -= buf->size;
+
+            std::free(buf->data);
+            delete buf;
+        }
+    }
+}
@@ -0,0 +1,205 @@
+#include "../include/compact.hpp"
+
+
+// bits 0, ..., x-1
+static inline uint64_t BitsBelow (int x)
+{
+    return (uint64_t(1) << x) - 1;
+}
+
+// logical qubits assigned at the depths 0, ..., depth-1
+static uint64_t AssignedLogicalQubits (const vector<int>& priority, int depth)
+{
+    uint64_t assigned = 0;
+
+    for (int d = 0; d < depth; ++d)
+        assigned |= uint64_t(1) << priority[d];
+
+    return assigned;
+}
+
+// local index of q_i among the logical qubits still to assign
+static inline int LocalLogicalIndex (uint64_t assigned, int i)
+{
+    return i - __builtin_popcountll(assigned & BitsBelow(i));
+}
+
+// local index of P_j among the available physical qubits
+static inline int LocalPhysicalIndex (uint64_t available, int j)
+{
+    return __builtin_popcountll(available & BitsBelow(j));
+}
+
+
+vector<int> CompactNode::mapping (const vector<int>& priority, int n) const
+{
+    vector<int> map(n, -1);
+
+    for (int d = 0; d < size; ++d)
+        map[priority[d]] = path[d];
+
+    return map;
+}
+
+
+CompactNode CompactNode::Root (int m)
+{
+    assert(m <= MAX_QUBITS && "Error: Compact nodes support at most 64 physical qubits.");
+
+    CompactNode node{};
+    node.available = (m == MAX_QUBITS) ? ~uint64_t(0) : BitsBelow(m);
+    node.lower_bound = 0;
+    node.size = 0;
+
+    return node;
+}
+
+
+void CompactNode::WriteSegment (FILE* file, const CompactNode* nodes, size_t count)
+{
+    const uint64_t nb_nodes = count;
+
+    WriteBytes(file, &nb_nodes, sizeof(nb_nodes));
+    WriteBytes(file, nodes, count * sizeof(CompactNode));
+}
+
+
+vector<CompactNode> CompactNode::ReadSegment (FILE* file)
+{
+    uint64_t nb_nodes;
+
+    ReadBytes(file, &nb_nodes, sizeof(nb_nodes));
+
+    vector<CompactNode> nodes(nb_nodes);
+    ReadBytes(file, nodes.data(), nb_nodes * sizeof(CompactNode));
+
+    return nodes;
+}
+
+
+template <typename T>
+ReplayCache<T>::ReplayCache (CostMatrix<T>&& root, const vector<int>& priority, int n, int m) : priority(priority), n(n), m(m),
+                                                                                                ancestors(n + 1),
+                                                                                                matrices(n + 1),
+                                                                                                lower_bounds(n + 1, 0),
+                                                                                                cached(n + 1, false)
+{
+    store(CompactNode::Root(m), std::move(root), 0);
+}
+
+
+template <typename T>
+void ReplayCache<T>::store (const CompactNode& node, CostMatrix<T>&& CM, int lb)
+{
+    const int d = node.size;
+
+    ancestors[d] = node;
+    matrices[d] = std::move(CM);
+    lower_bounds[d] = lb;
+    cached[d] = true;
+}
+
+
+template <typename T>
+Node<T> ReplayCache<T>::replay (const CompactNode& node)
+{
+    const int d = node.size;
+
+    // deepest cached ancestor, the root being always cached
+    int e = d;
+    while (e > 0 && !(cached[e] && std::equal(node.path, node.path + e, ancestors[e].path)))
+        --e;
+
+    CostMatrix<T> CM = matrices[e].clone();
+    int lb = lower_bounds[e];
+
+    uint64_t assigned = AssignedLogicalQubits(priority, e);
+    uint64_t available = ancestors[e].available;
+
+    for (int s = e; s < d; ++s)
+    {
+        const int i = priority[s];
+        const int j = node.path[s];
+
+        const int k = LocalLogicalIndex(assigned, i);
+        const int l = LocalPhysicalIndex(available, j);
+
+        lb = CheckedAdd(lb, CM.get_leader()[k*CM.get_cols() + l]);
+        CM = CM.reduce(k, l);
+
+        assigned |= uint64_t(1) << i;
+        available &= ~(uint64_t(1) << j);
+    }
+
+    // reductions beyond the parent's one
+    nb_replays += std::max(0, d - e - 1);
+
+    Solution sol;
+    sol.mapping = node.mapping(priority, n);
+    sol.cost = -1;
+
+    vector<bool> av(m);
+    for (int j = 0; j < m; ++j)
+        av[j] = (node.available >> j) & 1;
+
+    // the replayed node owns its mapping and availability
+    Arena::CountNodeStates(1);
+
+    // the lower bound matches the replayed matrix, it may be weaker than the one of the pool entry
+    return Node<T>{std::move(sol), d, lb, std::move(CM), std::move(av)};
+}
+
+
+template <typename T>
+void CompactChildren (const BoundingOptions& options, const CompactNode& node, const CostMatrix<T>& CM, int lb, const vector<int>& priority,
+                      int n, int m, int min_cost, vector<CompactNode>& children)
+{
+    children.clear();
+
+    const int sz = node.size;
+
+    // next logical qubit q_i to assign, and its local index in the cost matrix
+    const int i = priority[sz];
+    const int k = LocalLogicalIndex(AssignedLogicalQubits(priority, sz), i);
+
+    // increment lower bound of each available physical qubit, the parent's one remaining valid for its children,
+    // and push order of the children, scratch of the calling thread
+    static thread_local vector<bool> av;
+    static thread_local vector<int> lbs, order;
+
+    av.assign(m, false);
+    lbs.assign(m, INF);
+
+    for (int j = 0, l = 0; j < m; ++j)
+    {
+        av[j] = (node.available >> j) & 1;
+
+        if (av[j])
+            lbs[j] = std::max(CheckedAdd(lb, CM.get_leader()[k*CM.get_cols() + l++]), node.lower_bound);
+    }
+
+    // iterate over the surviving physical qubits, in the same order as Node::decompose
+    options.ChildOrder(lbs, av, min_cost, order);
+
+    for (int j : order)
+    {
+        const int lb_new = lbs[j];
+
+        CompactNode child = node;
+        child.path[sz] = j;
+        child.available &= ~(uint64_t(1) << j);
+        child.size = sz + 1;
+        child.lower_bound = lb_new;
+
+        children.push_back(child);
+    }
+}
+
+
+template class ReplayCache<int16_t>;
+template class ReplayCache<int32_t>;
+template class ReplayCache<int64_t>;
+
+template void CompactChildren (const BoundingOptions&, const CompactNode&, const CostMatrix<int16_t>&, int, const vector<int>&, int, int, int, vector<CompactNode>&);
+template void CompactChildren (const BoundingOptions&, const CompactNode&, const CostMatrix<int32_t>&, int, const vector<int>&, int, int, int, vector<CompactNode>&);
+template void CompactChildren (const BoundingOptions&, const CompactNode&, const CostMatrix<int64_t>&, int, const vector<int>&, int, int, int, vector<CompactNode>&);
@@ -1,89 +1,179 @@
 #include "../include/hungarian.hpp"
+#include "../include/kernels.hpp"
 
 
-/**
- * Sets a = min(a, b)
- * @return true if b < a
- */
-bool ckmin(int &a, const int &b) 
-{ 
-    return b < a ? (a = b, true) : false; 
+template <typename T>
+void HungarianSolver<T>::reserve (int n, int m)
+{
+    if ((int)yw.size() < n)
+        yw.resize(n);
+
+    if ((int)job.size() < m + 1)
+    {
+        job.resize(m + 1);
+        prv.resize(m + 1);
+        yj.resize(m + 1);
+        min_to.resize(m + 1);
+        in_Z.resize(m + 1);
+        Z.resize(m + 1);
+    }
 }
 
+
+template <typename T>
+HungarianSolver<T>& HungarianSolver<T>::Local ()
+{
+    static thread_local HungarianSolver solver;
+    return solver;
+}
+
+
 /**
  * Hungarian algorithm implementation that modifies the input cost matrix and returns
  * the optimal assignment cost, while modifying the permutation vector.
  *
- * @param C A reference to a matrix of dimensions n×n such that C[w][j] is the cost
- *          of assigning the w-th worker to the j-th job (possibly negative).
- * @param i0 row index of the cost sub-matrix C
- * @param j0 column index of the cost sub-matrix C
- * @param n size of the input cost matrix C
+ * @param C A pointer to a row-major matrix of dimensions n×m such that C[w*m + j] is the
+ *          cost of assigning the w-th worker to the j-th job (possibly negative).
+ * @param n number of workers (rows) of the input cost matrix C
+ * @param m number of jobs (columns) of the input cost matrix C, with n <= m
  * @return The minimum assignment cost.
+ *
+ * With non-negative costs bounded by c_max, potentials stay within [-c_max, c_max] and
+ * reduced costs within [0, 2*c_max], so T only needs a 4*c_max headroom.
+ *
+ * The scans over the jobs are branch-free so that they vectorize: the reduced costs update
+ * min_to and prv under the mask of the jobs out of Z while the masked min gives delta, and the
+ * first job reaching it is the masked min of the job indices, so ties keep the lowest index as
+ * a sequential search would. Masks, predecessors and indices have the width of T to share its
+ * vector lanes, and the workers of Z are listed apart for the potentials update.
+ * The versions with M > 0 are only called with m = M, which makes their loop bounds constant.
+ *
+ * The potentials stay dual feasible throughout, yj <= 0 and yw not above the row minima, and
+ * each step of the shortest path search raises their dual objective by delta. Once it exceeds
+ * threshold, the optimal cost does too: the solve stops and returns it, C being left as is.
  */
-int Hungarian (int* C, int i0, int j0, int n)
+template <int M, typename T>
+static inline __attribute__((always_inline)) T Hungarian_Body (T* __restrict C, int n, int m, int* __restrict assign, T threshold, int* __restrict job,
+                                                               T* __restrict prv, T* __restrict yw, T* __restrict yj, T* __restrict min_to,
+                                                               T* __restrict in_Z, int* __restrict Z)
 {
+    if constexpr (M > 0)
+        m = M;
+
     int w, j, w_cur, j_cur, j_next;
 
-    const int inf = INF / 2;
+    const T inf = std::numeric_limits<T>::max() / 2;
 
     // job[j] = worker assigned to job j, or -1 if unassigned
-    vector<int> job(n + 1, -1);
+    std::fill(job, job + m + 1, -1);
 
     // yw[w] is the potential for worker w
     // yj[j] is the potential for job j
-    vector<int> yw(n, 0), yj(n + 1, 0);
+    std::fill(yw, yw + n, 0);
+    std::fill(yj, yj + m + 1, 0);
+
+    // dual objective of the potentials, sum of yw and of yj over the real jobs
+    T dual = 0;
+
+    // warm start: row reduced potentials, rows keeping their previous column while it stays tight
+    if (assign != nullptr)
+    {
+        for (w = 0; w < n; ++w)
+        {
+            const T* row = C + w*m;
+            T row_min = row[0];
+
+            for (j = 1; j < m; ++j)
+                row_min = std::min(row_min, row[j]);
+
+            yw[w] = row_min;
+            dual += row_min;
+        }
+
+        for (w = 0; w < n; ++w)
+        {
+            const int a = assign[w];
+
+            if (a >= 0 && C[w*m + a] == yw[w] && job[a] == -1)
+                job[a] = w;
+            else
+                assign[w] = -1;
+        }
+    }
 
     // main Hungarian algorithm
     for (w_cur = 0; w_cur < n; ++w_cur)
     {
-        j_cur = n;
+        // rows kept by the warm start are already assigned
+        if (assign != nullptr && assign[w_cur] >= 0)
+            continue;
+
+        j_cur = m;
         job[j_cur] = w_cur;
 
-        vector<int> min_to(n + 1, inf);
-        vector<int> prv(n + 1, -1);
-        vector<bool> in_Z(n + 1, false);
+        std::fill(min_to, min_to + m + 1, inf);
+        std::fill(prv, prv + m + 1, -1);
+        std::fill(in_Z, in_Z + m + 1, 0);
+
+        // Z[0..nb_Z-1] = jobs of Z, in their order of insertion
+        int nb_Z = 0;
 
         while (job[j_cur] != -1)
         {
-            in_Z[j_cur] = true;
+            in_Z[j_cur] = 1;
+            Z[nb_Z++] = j_cur;
             w = job[j_cur];
-            int delta = inf;
-            j_next = 0;
 
-            for (j = 0; j < n; ++j)
+            const T* __restrict row = C + w*m;
+            const T yw_w = yw[w];
+            const T j_prv = j_cur;
+
+            // smallest min_to out of Z
+            T delta = inf;
+
+            // reduced cost = C[w][j] - yw[w] - yj[j]
+            for (j = 0; j < m; ++j)
             {
-                if (!in_Z[j])
-                {
-                    // reduced cost = C[w][j] - yw[w] - yj[j]
-                    int cur_cost = C[idx4D(i0, j0, w, j, n)] - yw[w] - yj[j];
-
-                    if (ckmin(min_to[j], cur_cost))
-                        prv[j] = j_cur;
-                    if (ckmin(delta, min_to[j])) 
-                        j_next = j;
-                }
+                const T cur_cost = row[j] - yw_w - yj[j];
+                const bool better = !in_Z[j] && cur_cost < min_to[j];
+
+                min_to[j] = better ? cur_cost : min_to[j];
+                prv[j] = better ? j_prv : prv[j];
+
+                delta = std::min(delta, in_Z[j] ? inf : min_to[j]);
             }
 
+            // first job reaching it as a masked min of the indices, job 0 if none is below inf
+            T first = T(m);
+
+            for (j = 0; j < m; ++j)
+                first = std::min(first, (!in_Z[j] && min_to[j] == delta) ? T(j) : T(m));
+
+            j_next = (delta < inf) ? int(first) : 0;
+
             // update potentials
-            for (j = 0; j <= n; ++j)
+            for (int z = 0; z < nb_Z; ++z)
+                yw[job[Z[z]]] += delta;
+
+            for (j = 0; j <= m; ++j)
             {
-                if (in_Z[j])
-                {
-                    yw[job[j]] += delta;
-                    yj[j] -= delta;
-                }
-                else
-                {
-                    min_to[j] -= delta;
-                }
+                const T delta_Z = in_Z[j] ? delta : T(0);
+
+                yj[j] -= delta_Z;
+                min_to[j] -= delta - delta_Z;
             }
 
             j_cur = j_next;
+
+            // the nb_Z workers of Z gain delta, its nb_Z - 1 real jobs lose it
+            dual += delta;
+
+            if (dual > threshold)
+                return dual;
         }
 
         // update worker assignment along the found augmenting path
-        for (; j_cur != n; j_cur = j)
+        for (; j_cur != m; j_cur = j)
         {
             j = prv[j_cur];
             job[j_cur] = job[j];
@@ -91,28 +181,467 @@ int Hungarian (int* C, int i0, int j0, int n)
     }
 
     // compute total cost
-    int total_cost = 0;
+    T total_cost = 0;
 
-    // for j in [0..n-1], job[j] is the worker assigned to job j
-    for (j = 0; j < n; ++j)
+    // for j in [0..m-1], job[j] is the worker assigned to job j
+    for (j = 0; j < m; ++j)
     {
         if (job[j] != -1)
-            total_cost += C[idx4D(i0, j0, job[j], j, n)];
+        {
+            total_cost += C[job[j]*m + j];
+
+            if (assign != nullptr)
+                assign[job[j]] = j;
+        }
     }
 
     // OPTIONAL: Reflecting the "reduced costs" after the Hungarian
     // algorithm by applying the final potentials:
     for (w = 0; w < n; ++w)
     {
-        for (j = 0; j < n; ++j)
+        const T yw_w = yw[w];
+
+        for (j = 0; j < m; ++j)
+        {
+            // subtract the final potentials from the original cost
+            C[w*m + j] -= yw_w + yj[j];
+        }
+    }
+
+    return total_cost;
+}
+
+
+/* baseline, AVX2 and AVX-512 versions, selected once per solve */
+
+template <int M, typename T>
+static T Hungarian_Default (T* C, int n, int m, int* assign, T threshold, int* job, T* prv, T* yw, T* yj, T* min_to, T* in_Z, int* Z)
+{
+    return Hungarian_Body<M>(C, n, m, assign, threshold, job, prv, yw, yj, min_to, in_Z, Z);
+}
+
+#ifdef KERNELS_AVX2
+template <int M, typename T>
+__attribute__((target("avx2"))) static T Hungarian_AVX2 (T* C, int n, int m, int* assign, T threshold, int* job, T* prv, T* yw, T* yj, T* min_to, T* in_Z, int* Z)
+{
+    return Hungarian_Body<M>(C, n, m, assign, threshold, job, prv, yw, yj, min_to, in_Z, Z);
+}
+#endif
+
+#ifdef KERNELS_AVX512
+template <int M, typename T>
+__attribute__((target("avx512f,avx512bw"))) static T Hungarian_AVX512 (T* C, int n, int m, int* assign, T threshold, int* job, T* prv, T* yw, T* yj, T* min_to, T* in_Z, int* Z)
+{
+    return Hungarian_Body<M>(C, n, m, assign, threshold, job, prv, yw, yj, min_to, in_Z, Z);
+}
+#endif
+
+
+template <int M, typename T>
+static T Hungarian_Dispatch (T* C, int n, int m, int* assign, T threshold, int* job, T* prv, T* yw, T* yj, T* min_to, T* in_Z, int* Z)
+{
+#ifdef KERNELS_AVX512
+    if (UseAVX512())
+        return Hungarian_AVX512<M>(C, n, m, assign, threshold, job, prv, yw, yj, min_to, in_Z, Z);
+#endif
+#ifdef KERNELS_AVX2
+    if (UseAVX2())
+        return Hungarian_AVX2<M>(C, n, m, assign, threshold, job, prv, yw, yj, min_to, in_Z, Z);
+#endif
+    return Hungarian_Default<M>(C, n, m, assign, threshold, job, prv, yw, yj, min_to, in_Z, Z);
+}
+
+
+template <typename T>
+T HungarianSolver<T>::solve (T* C, int n, int m, int* assign, T threshold)
+{
+    return DispatchSize(m, [&](auto size)
+    {
+        constexpr int M = decltype(size)::value;
+
+        if constexpr (M > 0)
         {
-            if (C[idx4D(i0, j0, w, j, n)] < inf)
+            // small LAPs keep their scratch on the stack, n <= m
+            int job_s[M + 1], Z_s[M + 1];
+            T prv_s[M + 1], yw_s[M], yj_s[M + 1], min_to_s[M + 1], in_Z_s[M + 1];
+
+            return Hungarian_Dispatch<M>(C, n, m, assign, threshold, job_s, prv_s, yw_s, yj_s, min_to_s, in_Z_s, Z_s);
+        }
+        else
+        {
+            reserve(n, m);
+
+            return Hungarian_Dispatch<0>(C, n, m, assign, threshold, job.data(), prv.data(), yw.data(), yj.data(), min_to.data(), in_Z.data(), Z.data());
+        }
+    });
+}
+
+
+template <typename T>
+void BatchHungarian<T>::reserve (int n, int m)
+{
+    const int W = LANES;
+
+    if ((int)costs.size() < n*m*W)
+        costs.resize(n*m*W);
+
+    if ((int)yw.size() < n*W)
+        yw.resize(n*W);
+
+    if ((int)job.size() < (m + 1)*W)
+    {
+        job.resize((m + 1)*W);
+        prv.resize((m + 1)*W);
+        yj.resize((m + 1)*W);
+        min_to.resize((m + 1)*W);
+        in_Z.resize((m + 1)*W);
+        Z.resize((m + 1)*W);
+    }
+}
+
+
+template <typename T>
+BatchHungarian<T>& BatchHungarian<T>::Local ()
+{
+    static thread_local BatchHungarian solver;
+    return solver;
+}
+
+
+/*
+ * Same algorithm as Hungarian_Body, run by each lane b < nb_blocks on block blocks[b]: the
+ * per-lane bookkeeping stays scalar, while the scans over the jobs process the W lanes of
+ * each job at once. Z holds the jobs of Z of lane b from Z[b*(m + 1)], and idle lanes take
+ * a zero delta so that their potentials no longer move. The lanes hold entries of type G,
+ * wider than T for int16_t: the cost type headroom keeps every value within the range of T,
+ * hence the same results. As in Hungarian_Body, M > 0 fixes m at compile time.
+ */
+template <int W, int M, typename T, typename G>
+static inline __attribute__((always_inline)) void BatchHungarian_Body (T* C, int block_size, const int* blocks, int nb_blocks, int n, int m, T* opt, int* assign,
+                                                                       G* __restrict Cb, int* __restrict job, G* __restrict prv,
+                                                                       G* __restrict yw, G* __restrict yj, G* __restrict min_to,
+                                                                       G* __restrict in_Z, int* __restrict Z)
+{
+    if constexpr (M > 0)
+        m = M;
+
+    const G inf = std::numeric_limits<T>::max() / 2;
+
+    // offsets of the block of lane b and of its assignment, idle lanes pointing to the first block
+    int base[W], assign_base[W];
+
+    for (int b = 0; b < W; ++b)
+    {
+        const int block = blocks[(b < nb_blocks) ? b : 0];
+
+        base[b] = block*block_size;
+        assign_base[b] = block*n;
+    }
+
+    // lane b holds its block, idle lanes a zero problem
+    for (int x = 0; x < n*m; ++x)
+    {
+        for (int b = 0; b < W; ++b)
+            Cb[x*W + b] = (b < nb_blocks) ? C[base[b] + x] : G(0);
+    }
+
+    std::fill(job, job + (m + 1)*W, -1);
+    std::fill(yw, yw + n*W, 0);
+    std::fill(yj, yj + (m + 1)*W, 0);
+
+    // warm start: row reduced potentials, rows keeping their previous column while it stays tight
+    if (assign != nullptr)
+    {
+        for (int w = 0; w < n; ++w)
+        {
+            G* __restrict yw_row = yw + w*W;
+            const G* __restrict row = Cb + w*m*W;
+
+            for (int j = 0; j < m; ++j)
             {
-                // subtract the final potentials from the original cost
-                C[idx4D(i0, j0, w, j, n)] = C[idx4D(i0, j0, w, j, n)] - yw[w] - yj[j];
+                #pragma omp simd
+                for (int b = 0; b < W; ++b)
+                    yw_row[b] = (j == 0) ? row[b] : std::min(yw_row[b], row[j*W + b]);
+            }
+        }
+
+        for (int b = 0; b < nb_blocks; ++b)
+        {
+            int* A = assign + assign_base[b];
+
+            for (int w = 0; w < n; ++w)
+            {
+                const int a = A[w];
+
+                if (a >= 0 && Cb[(w*m + a)*W + b] == yw[w*W + b] && job[a*W + b] == -1)
+                    job[a*W + b] = w;
+                else
+                    A[w] = -1;
             }
         }
     }
 
-    return total_cost;
+    int w_cur[W], j_cur[W], nb_Z[W], row_off[W];
+    bool active[W];
+    G yw_w[W], j_prv[W], delta[W], j_next[W];
+
+    // next worker of lane b gets its search started from the dummy job m
+    auto start_row = [&](int b)
+    {
+        j_cur[b] = m;
+        job[m*W + b] = w_cur[b];
+        nb_Z[b] = 0;
+
+        for (int j = 0; j <= m; ++j)
+        {
+            min_to[j*W + b] = inf;
+            prv[j*W + b] = -1;
+            in_Z[j*W + b] = 0;
+        }
+    };
+
+    int nb_active = 0;
+
+    // lane b moves on to its next row, the ones kept by the warm start being skipped
+    auto next_row = [&](int b)
+    {
+        while (++ w_cur[b] < n && assign != nullptr && assign[assign_base[b] + w_cur[b]] >= 0) {}
+
+        if (w_cur[b] < n)
+        {
+            start_row(b);
+        }
+        else
+        {
+            active[b] = false;
+            -- nb_active;
+        }
+    };
+
+    for (int b = 0; b < W; ++b)
+    {
+        w_cur[b] = -1;
+        active[b] = (b < nb_blocks);
+
+        if (active[b])
+        {
+            ++ nb_active;
+            next_row(b);
+        }
+    }
+
+    while (nb_active > 0)
+    {
+        // add the current job of each lane to its Z
+        for (int b = 0; b < W; ++b)
+        {
+            row_off[b] = b;
+            yw_w[b] = 0;
+            j_prv[b] = 0;
+
+            if (active[b])
+            {
+                const int w = job[j_cur[b]*W + b];
+
+                in_Z[j_cur[b]*W + b] = 1;
+                Z[b*(m + 1) + nb_Z[b]++] = j_cur[b];
+
+                row_off[b] = w*m*W + b;
+                yw_w[b] = yw[w*W + b];
+                j_prv[b] = j_cur[b];
+            }
+
+            delta[b] = inf;
+        }
+
+        // reduced cost = C[w][j] - yw[w] - yj[j], and smallest min_to out of Z
+        for (int j = 0; j < m; ++j)
+        {
+            G* __restrict mt = min_to + j*W;
+            G* __restrict pv = prv + j*W;
+            const G* __restrict iz = in_Z + j*W;
+            const G* __restrict yjj = yj + j*W;
+
+            #pragma omp simd
+            for (int b = 0; b < W; ++b)
+            {
+                const G cur_cost = Cb[row_off[b] + j*W] - yw_w[b] - yjj[b];
+                const bool better = (iz[b] == 0) & (cur_cost < mt[b]);
+
+                mt[b] = better ? cur_cost : mt[b];
+                pv[b] = better ? j_prv[b] : pv[b];
+
+                delta[b] = std::min(delta[b], iz[b] ? inf : mt[b]);
+            }
+        }
+
+        // first job reaching delta, job 0 if none is below inf
+        for (int b = 0; b < W; ++b)
+            j_next[b] = 0;
+
+        for (int j = m - 1; j >= 0; --j)
+        {
+            const G* __restrict mt = min_to + j*W;
+            const G* __restrict iz = in_Z + j*W;
+
+            #pragma omp simd
+            for (int b = 0; b < W; ++b)
+                j_next[b] = ((iz[b] == 0) & (mt[b] == delta[b]) & (delta[b] < inf)) ? G(j) : j_next[b];
+        }
+
+        // update potentials, idle lanes left as they are
+        for (int b = 0; b < W; ++b)
+        {
+            if (!active[b])
+            {
+                delta[b] = 0;
+                continue;
+            }
+
+            for (int z = 0; z < nb_Z[b]; ++z)
+                yw[job[Z[b*(m + 1) + z]*W + b]*W + b] += delta[b];
+        }
+
+        for (int j = 0; j <= m; ++j)
+        {
+            G* __restrict mt = min_to + j*W;
+            G* __restrict yjj = yj + j*W;
+            const G* __restrict iz = in_Z + j*W;
+
+            #pragma omp simd
+            for (int b = 0; b < W; ++b)
+            {
+                const G delta_Z = iz[b] ? delta[b] : G(0);
+
+                yjj[b] -= delta_Z;
+                mt[b] -= delta[b] - delta_Z;
+            }
+        }
+
+        // lanes reaching a free job augment along their path, then start their next worker
+        for (int b = 0; b < W; ++b)
+        {
+            if (!active[b])
+                continue;
+
+            j_cur[b] = j_next[b];
+
+            if (job[j_cur[b]*W + b] != -1)
+                continue;
+
+            for (int jc = j_cur[b], j; jc != m; jc = j)
+            {
+                j = prv[jc*W + b];
+                job[jc*W + b] = job[j*W + b];
+            }
+
+            next_row(b);
+        }
+    }
+
+    // optimal costs, then reduced costs written back to the blocks
+    for (int b = 0; b < nb_blocks; ++b)
+    {
+        T total_cost = 0;
+
+        for (int j = 0; j < m; ++j)
+        {
+            const int w = job[j*W + b];
+
+            if (w != -1)
+            {
+                total_cost += T(Cb[(w*m + j)*W + b]);
+
+                if (assign != nullptr)
+                    assign[assign_base[b] + w] = j;
+            }
+        }
+
+        opt[blocks[b]] = total_cost;
+
+        T* block = C + base[b];
+
+        for (int w = 0; w < n; ++w)
+        {
+            for (int j = 0; j < m; ++j)
+                block[w*m + j] = T(Cb[(w*m + j)*W + b] - (yw[w*W + b] + yj[j*W + b]));
+        }
+    }
+}
+
+
+#ifdef KERNELS_AVX2
+template <int M, typename T, typename G>
+__attribute__((target("avx2"))) static void BatchHungarian_AVX2 (T* C, int block_size, const int* blocks, int nb_blocks, int n, int m, T* opt, int* assign,
+                                                                  G* Cb, int* job, G* prv, G* yw, G* yj, G* min_to, G* in_Z, int* Z)
+{
+    BatchHungarian_Body<BatchHungarian<T>::LANES, M>(C, block_size, blocks, nb_blocks, n, m, opt, assign, Cb, job, prv, yw, yj, min_to, in_Z, Z);
+}
+#endif
+
+#ifdef KERNELS_AVX512
+template <int M, typename T, typename G>
+__attribute__((target("avx512f,avx512bw"))) static void BatchHungarian_AVX512 (T* C, int block_size, const int* blocks, int nb_blocks, int n, int m, T* opt, int* assign,
+                                                                                G* Cb, int* job, G* prv, G* yw, G* yj, G* min_to, G* in_Z, int* Z)
+{
+    BatchHungarian_Body<BatchHungarian<T>::LANES, M>(C, block_size, blocks, nb_blocks, n, m, opt, assign, Cb, job, prv, yw, yj, min_to, in_Z, Z);
+}
+#endif
+
+
+template <typename T>
+void BatchHungarian<T>::solve (T* C, int block_size, const int* blocks, int nb_blocks, int n, int m, T* opt, int* assign)
+{
+    assert(nb_blocks <= LANES && "Error: Too many blocks for one batch.");
+
+    // lanes need gathers to pay off, hence the blocks are solved one by one otherwise
+    if (nb_blocks == 1 || !UseAVX2())
+    {
+        HungarianSolver<T>& lap = HungarianSolver<T>::Local();
+
+        for (int b = 0; b < nb_blocks; ++b)
+            opt[blocks[b]] = lap.solve(C + blocks[b]*block_size, n, m, assign ? assign + blocks[b]*n : nullptr);
+
+        return;
+    }
+
+    reserve(n, m);
+
+    DispatchSize(m, [&](auto size)
+    {
+        constexpr int M = decltype(size)::value;
+
+#ifdef KERNELS_AVX512
+        if (UseAVX512())
+        {
+            BatchHungarian_AVX512<M>(C, block_size, blocks, nb_blocks, n, m, opt, assign, costs.data(), job.data(), prv.data(), yw.data(), yj.data(),
+                                     min_to.data(), in_Z.data(), Z.data());
+            return;
+        }
+#endif
+#ifdef KERNELS_AVX2
+        BatchHungarian_AVX2<M>(C, block_size, blocks, nb_blocks, n, m, opt, assign, costs.data(), job.data(), prv.data(), yw.data(), yj.data(),
+                               min_to.data(), in_Z.data(), Z.data());
+#endif
+    });
+}
+
+
+template <typename T>
+T Hungarian (T* C, int n, int m)
+{
+    return HungarianSolver<T>::Local().solve(C, n, m);
 }
+
+
+template class HungarianSolver<int16_t>;
+template class HungarianSolver<int32_t>;
+template class HungarianSolver<int64_t>;
+
+template class BatchHungarian<int16_t>;
+template class BatchHungarian<int32_t>;
+template class BatchHungarian<int64_t>;
+
+template int16_t Hungarian<int16_t> (int16_t* C, int n, int m);
+template int32_t Hungarian<int32_t> (int32_t* C, int n, int m);
+template int64_t Hungarian<int64_t> (int64_t* C, int n, int m);
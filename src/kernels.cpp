@@ -0,0 +1,370 @@
+#include "../include/kernels.hpp"
+
+
+bool UseAVX2 ()
+{
+#ifdef KERNELS_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+
+bool UseAVX512 ()
+{
+#ifdef KERNELS_AVX512
+    static const bool avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    return avx512;
+#else
+    return false;
+#endif
+}
+
+
+/* kernel bodies, inlined into both the AVX2 and the baseline versions */
+
+// or-reduction over the whole block, without early exit so that it vectorizes
+template <typename T>
+static inline __attribute__((always_inline)) bool IsZeroBlock_Body (const T* block, int size)
+{
+    // chunks of 64 bytes, a nonzero block being told apart by its first ones
+    const int chunk = 64 / sizeof(T);
+
+    for (int x0 = 0; x0 < size; x0 += chunk)
+    {
+        const int x1 = std::min(size, x0 + chunk);
+
+        T any = 0;
+
+        for (int x = x0; x < x1; ++x)
+            any |= block[x];
+
+        if (any != 0)
+            return false;
+    }
+
+    return true;
+}
+
+template <typename T>
+static inline __attribute__((always_inline)) void AddRowValues_Body (T* block, const T* vals, int nb_rows, int row_len)
+{
+    for (int r = 0; r < nb_rows; ++r)
+    {
+        T* row = block + r*row_len;
+        const T val = vals[r];
+
+        for (int l = 0; l < row_len; ++l)
+            row[l] += val;
+    }
+}
+
+// halves a[q] + b[q], entry q having the index parity (parity + q) % 2
+template <typename T>
+static inline __attribute__((always_inline)) void HalveSpan (T* __restrict a, T* __restrict b, int len, int parity)
+{
+    for (int q = 0; q < len; ++q)
+    {
+        const T cost_sum = a[q] + b[q];
+        const T half = cost_sum / 2;
+        const T odd = (cost_sum % 2 == 1);
+        const T even_parity = ((parity + q) & 1) ^ 1;
+
+        a[q] = half + (odd & even_parity);
+        b[q] = half + (odd & (even_parity ^ 1));
+    }
+}
+
+// share of the leader entry leader_cost of block (x, y) received by the row of q_k, k != x
+template <typename T>
+static inline __attribute__((always_inline)) T LeaderShare (T leader_cost, int x, int k, int n)
+{
+    const T leader_cost_div = leader_cost / (n - 1);
+    const T leader_cost_rem = leader_cost % (n - 1);
+
+    return leader_cost_div + (k < leader_cost_rem || (k == leader_cost_rem && x < k));
+}
+
+// with a leader L, its entries are first spread over the rows of the pair (distribute == true), M > 0 fixing m
+template <bool distribute, int M, typename T>
+static inline __attribute__((always_inline)) void HalveRowPair_Body (T* C, const T* L, int n, int m, int i, int k, T* tmp)
+{
+    if constexpr (M > 0)
+        m = M;
+
+    const int block_size = (n - 1)*(m - 1);
+    const int row_len = m - 1;
+
+    // shares of the leaders of blocks (k, l) received by their row of q_i
+    T* shares = tmp + row_len;
+
+    if (distribute)
+    {
+        for (int l = 0; l < m; ++l)
+            shares[l] = LeaderShare(L[k*m + l], k, i, n);
+    }
+
+    for (int j = 0; j < m; ++j)
+    {
+        // local row of q_k in block (i, j), k > i
+        T* row = C + (i*m + j)*block_size + (k - 1)*row_len;
+
+        if (distribute)
+        {
+            const T share = LeaderShare(L[i*m + j], i, k, n);
+
+            for (int p = 0; p < row_len; ++p)
+                row[p] += share;
+        }
+
+        // gather the mirrored entries C_kl[i][j], local row i of block (k, l)
+        for (int p = 0; p < row_len; ++p)
+        {
+            const int l = p + (p >= j);
+            tmp[p] = C[(k*m + l)*block_size + i*row_len + j - (j > l)];
+
+            if (distribute)
+                tmp[p] += shares[l];
+        }
+
+        // local column p holds P_l = P_p before P_j, P_(p+1) after it
+        HalveSpan(row, tmp, j, i + j + k);
+        HalveSpan(row + j, tmp + j, row_len - j, i + 2*j + k + 1);
+
+        for (int p = 0; p < row_len; ++p)
+        {
+            const int l = p + (p >= j);
+            C[(k*m + l)*block_size + i*row_len + j - (j > l)] = tmp[p];
+        }
+    }
+}
+
+
+template <int M, typename T>
+static inline __attribute__((always_inline)) int FixRowPair_Body (T* C, const T* L, int n, int m, int i, int k, int64_t gap)
+{
+    if constexpr (M > 0)
+        m = M;
+
+    const int block_size = (n - 1)*(m - 1);
+    const int row_len = m - 1;
+
+    const T value = FixingValue<T>(gap, n);
+
+    int nb_fixed = 0;
+
+    for (int j = 0; j < m; ++j)
+    {
+        // local row of q_k in block (i, j), k > i
+        T* row = C + (i*m + j)*block_size + (k - 1)*row_len;
+
+        const int64_t L_ij = L[i*m + j];
+
+        for (int p = 0; p < row_len; ++p)
+        {
+            const int l = p + (p >= j);
+
+            // mirrored entry C_kl[i][j], local row i of block (k, l)
+            T& mirror = C[(k*m + l)*block_size + i*row_len + j - (j > l)];
+
+            if (L_ij + L[k*m + l] + row[p] + mirror > gap)
+            {
+                nb_fixed += (row[p] < value) + (mirror < value);
+
+                row[p] = std::max(row[p], value);
+                mirror = std::max(mirror, value);
+            }
+        }
+    }
+
+    return nb_fixed;
+}
+
+
+/* baseline versions */
+
+template <typename T>
+static bool IsZeroBlock_Default (const T* block, int size)
+{
+    return IsZeroBlock_Body(block, size);
+}
+
+template <typename T>
+static void AddRowValues_Default (T* block, const T* vals, int nb_rows, int row_len)
+{
+    AddRowValues_Body(block, vals, nb_rows, row_len);
+}
+
+template <int M, typename T>
+static void HalveRowPair_Default (T* C, int n, int m, int i, int k, T* tmp)
+{
+    HalveRowPair_Body<false, M>(C, static_cast<const T*>(nullptr), n, m, i, k, tmp);
+}
+
+template <int M, typename T>
+static void DistributeHalveRowPair_Default (T* C, const T* L, int n, int m, int i, int k, T* tmp)
+{
+    HalveRowPair_Body<true, M>(C, L, n, m, i, k, tmp);
+}
+
+template <int M, typename T>
+static int FixRowPair_Default (T* C, const T* L, int n, int m, int i, int k, int64_t gap)
+{
+    return FixRowPair_Body<M>(C, L, n, m, i, k, gap);
+}
+
+
+/* AVX2 versions */
+
+#ifdef KERNELS_AVX2
+template <typename T>
+__attribute__((target("avx2"))) static bool IsZeroBlock_AVX2 (const T* block, int size)
+{
+    return IsZeroBlock_Body(block, size);
+}
+
+template <typename T>
+__attribute__((target("avx2"))) static void AddRowValues_AVX2 (T* block, const T* vals, int nb_rows, int row_len)
+{
+    AddRowValues_Body(block, vals, nb_rows, row_len);
+}
+
+template <int M, typename T>
+__attribute__((target("avx2"))) static void HalveRowPair_AVX2 (T* C, int n, int m, int i, int k, T* tmp)
+{
+    HalveRowPair_Body<false, M>(C, static_cast<const T*>(nullptr), n, m, i, k, tmp);
+}
+
+template <int M, typename T>
+__attribute__((target("avx2"))) static void DistributeHalveRowPair_AVX2 (T* C, const T* L, int n, int m, int i, int k, T* tmp)
+{
+    HalveRowPair_Body<true, M>(C, L, n, m, i, k, tmp);
+}
+
+template <int M, typename T>
+__attribute__((target("avx2"))) static int FixRowPair_AVX2 (T* C, const T* L, int n, int m, int i, int k, int64_t gap)
+{
+    return FixRowPair_Body<M>(C, L, n, m, i, k, gap);
+}
+#endif
+
+
+/* runtime dispatch */
+
+template <typename T>
+bool IsZeroBlock (const T* block, int size)
+{
+#ifdef KERNELS_AVX2
+    if (UseAVX2())
+        return IsZeroBlock_AVX2(block, size);
+#endif
+    return IsZeroBlock_Default(block, size);
+}
+
+template <typename T>
+void AddRowValues (T* block, const T* vals, int nb_rows, int row_len)
+{
+#ifdef KERNELS_AVX2
+    if (UseAVX2())
+    {
+        AddRowValues_AVX2(block, vals, nb_rows, row_len);
+        return;
+    }
+#endif
+    AddRowValues_Default(block, vals, nb_rows, row_len);
+}
+
+template <typename T>
+void HalveRowPair (T* C, int n, int m, int i, int k, T* tmp)
+{
+    DispatchSize(m, [&](auto size)
+    {
+        constexpr int M = decltype(size)::value;
+
+#ifdef KERNELS_AVX2
+        if (UseAVX2())
+        {
+            HalveRowPair_AVX2<M>(C, n, m, i, k, tmp);
+            return;
+        }
+#endif
+        HalveRowPair_Default<M>(C, n, m, i, k, tmp);
+    });
+}
+
+template <typename T>
+void DistributeHalveRowPair (T* C, const T* L, int n, int m, int i, int k, T* tmp)
+{
+    DispatchSize(m, [&](auto size)
+    {
+        constexpr int M = decltype(size)::value;
+
+#ifdef KERNELS_AVX2
+        if (UseAVX2())
+        {
+            DistributeHalveRowPair_AVX2<M>(C, L, n, m, i, k, tmp);
+            return;
+        }
+#endif
+        DistributeHalveRowPair_Default<M>(C, L, n, m, i, k, tmp);
+    });
+}
+
+template <typename T>
+int FixRowPair (T* C, const T* L, int n, int m, int i, int k, int64_t gap)
+{
+    return DispatchSize(m, [&](auto size)
+    {
+        constexpr int M = decltype(size)::value;
+
+#ifdef KERNELS_AVX2
+        if (UseAVX2())
+            return FixRowPair_AVX2<M>(C, L, n, m, i, k, gap);
+#endif
+        return FixRowPair_Default<M>(C, L, n, m, i, k, gap);
+    });
+}
+
+template <typename T>
+int FixLeader (T* L, int n, int m, int64_t gap)
+{
+    int nb_fixed = 0;
+
+    for (int x = 0; x < n*m; ++x)
+    {
+        if (L[x] > gap)
+        {
+            L[x] = static_cast<T>(gap + 1);
+            ++ nb_fixed;
+        }
+    }
+
+    return nb_fixed;
+}
+
+
+template bool IsZeroBlock<int16_t> (const int16_t*, int);
+template bool IsZeroBlock<int32_t> (const int32_t*, int);
+template bool IsZeroBlock<int64_t> (const int64_t*, int);
+
+template void AddRowValues<int16_t> (int16_t*, const int16_t*, int, int);
+template void AddRowValues<int32_t> (int32_t*, const int32_t*, int, int);
+template void AddRowValues<int64_t> (int64_t*, const int64_t*, int, int);
+
+template void HalveRowPair<int16_t> (int16_t*, int, int, int, int, int16_t*);
+template void HalveRowPair<int32_t> (int32_t*, int, int, int, int, int32_t*);
+template void HalveRowPair<int64_t> (int64_t*, int, int, int, int, int64_t*);
+
+template void DistributeHalveRowPair<int16_t> (int16_t*, const int16_t*, int, int, int, int, int16_t*);
+template void DistributeHalveRowPair<int32_t> (int32_t*, const int32_t*, int, int, int, int, int32_t*);
+template void DistributeHalveRowPair<int64_t> (int64_t*, const int64_t*, int, int, int, int, int64_t*);
+
+template int FixRowPair<int16_t> (int16_t*, const int16_t*, int, int, int, int, int64_t);
+template int FixRowPair<int32_t> (int32_t*, const int32_t*, int, int, int, int, int64_t);
+template int FixRowPair<int64_t> (int64_t*, const int64_t*, int, int, int, int, int64_t);
+
+template int FixLeader<int16_t> (int16_t*, int, int, int64_t);
+template int FixLeader<int32_t> (int32_t*, int, int, int64_t);
+template int FixLeader<int64_t> (int64_t*, int, int, int64_t);
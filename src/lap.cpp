@@ -0,0 +1,704 @@
+#include "../include/lap.hpp"
+
+
+LAPBackend LAP::blocks = LAPBackend::Hungarian;
+LAPBackend LAP::leader = LAPBackend::Hungarian;
+
+double LAP::nb_block_laps = 0;
+double LAP::nb_zero_blocks = 0;
+double LAP::nb_aborted = 0;
+
+
+void LAP::CountBlocks (int nb_solved, int nb_skipped)
+{
+    #pragma omp atomic
+    nb_block_laps += nb_solved;
+
+    #pragma omp atomic
+    nb_zero_blocks += nb_skipped;
+}
+
+
+LAPBackend LAP::Parse (const string& name)
+{
+    if (name == "hungarian")
+        return LAPBackend::Hungarian;
+    if (name == "jv")
+        return LAPBackend::JonkerVolgenant;
+    if (name == "auction")
+        return LAPBackend::Auction;
+
+    cerr << "Error: unknown LAP backend " << name << ", expected hungarian, jv or auction" << endl;
+    exit(1);
+}
+
+
+string LAP::Name (LAPBackend backend)
+{
+    switch (backend)
+    {
+        case LAPBackend::JonkerVolgenant:
+            return "jv";
+        case LAPBackend::Auction:
+            return "auction";
+        default:
+            return "hungarian";
+    }
+}
+
+
+template <typename T>
+T LAP::Solve (LAPBackend backend, T* C, int n, int m)
+{
+    switch (backend)
+    {
+        case LAPBackend::JonkerVolgenant:
+            return JVSolver<T>::Local().solve(C, n, m);
+        case LAPBackend::Auction:
+            return AuctionSolver<T>::Local().solve(C, n, m);
+        default:
+            return HungarianSolver<T>::Local().solve(C, n, m);
+    }
+}
+
+
+template <typename T>
+T LAP::SolveLeader (T* C, int n, int m, int64_t gap)
+{
+    if (leader != LAPBackend::Hungarian)
+        return Solve(leader, C, n, m);
+
+    const T threshold = static_cast<T>(std::min<int64_t>(gap, std::numeric_limits<T>::max()));
+    const T cost = HungarianSolver<T>::Local().solve(C, n, m, nullptr, threshold);
+
+    // solves stop as soon as their cost is known to exceed a threshold below the range of T
+    if (cost > threshold && threshold < std::numeric_limits<T>::max())
+    {
+        #pragma omp atomic
+        nb_aborted += 1;
+    }
+
+    return cost;
+}
+
+
+//----------------------------------- Jonker-Volgenant -----------------------------------//
+
+template <typename T>
+JVSolver<T>& JVSolver<T>::Local ()
+{
+    static thread_local JVSolver solver;
+    return solver;
+}
+
+
+template <typename T>
+void JVSolver<T>::reserve (int n, int m)
+{
+    if ((int)costs.size() < n*m)
+        costs.resize(n*m);
+
+    if ((int)v.size() < m)
+    {
+        v.resize(m);
+        d.resize(m);
+        rowsol.resize(m);
+        colsol.resize(m);
+        free_rows.resize(m);
+        collist.resize(m);
+        pred.resize(m);
+        matches.resize(m);
+    }
+}
+
+
+template <typename T>
+void JVSolver<T>::load (const T* C, int n, int m)
+{
+    reserve(n, m);
+
+    for (int x = 0; x < n*m; ++x)
+        costs[x] = C[x];
+}
+
+
+template <typename T>
+T JVSolver<T>::solve (T* C, int n, int m)
+{
+    load(C, n, m);
+
+    const int64_t* S = costs.data();
+    const int64_t big = std::numeric_limits<int64_t>::max() / 4;
+
+    int nb_free = 0;
+
+    if (n < m)
+    {
+        // the columns' potentials start at 0, rows taking their first minimum column while it is free
+        std::fill(v.begin(), v.begin() + m, 0);
+        std::fill(colsol.begin(), colsol.begin() + m, -1);
+
+        for (int i = 0; i < n; ++i)
+        {
+            int j_min = 0;
+
+            for (int j = 1; j < m; ++j)
+            {
+                if (S[i*m + j] < S[i*m + j_min])
+                    j_min = j;
+            }
+
+            if (colsol[j_min] < 0)
+            {
+                rowsol[i] = j_min;
+                colsol[j_min] = i;
+            }
+            else
+            {
+                free_rows[nb_free++] = i;
+            }
+        }
+    }
+    else
+    {
+        std::fill(matches.begin(), matches.begin() + n, 0);
+
+        // column reduction, each row keeping the first column it is the minimum of
+        for (int j = m - 1; j >= 0; --j)
+        {
+            int i_min = 0;
+
+            for (int i = 1; i < n; ++i)
+            {
+                if (S[i*m + j] < S[i_min*m + j])
+                    i_min = i;
+            }
+
+            v[j] = S[i_min*m + j];
+
+            if (++ matches[i_min] == 1)
+            {
+                rowsol[i_min] = j;
+                colsol[j] = i_min;
+            }
+            else
+            {
+                colsol[j] = -1;
+            }
+        }
+
+        // reduction transfer from the rows assigned once, the other unassigned rows being free
+        for (int i = 0; i < n; ++i)
+        {
+            if (matches[i] == 0)
+            {
+                free_rows[nb_free++] = i;
+            }
+            else if (matches[i] == 1 && m > 1)
+            {
+                const int j1 = rowsol[i];
+                int64_t min = big;
+
+                for (int j = 0; j < m; ++j)
+                {
+                    if (j != j1)
+                        min = std::min(min, S[i*m + j] - v[j]);
+                }
+
+                v[j1] -= min;
+            }
+        }
+    }
+
+    // augmenting row reduction, two passes
+    for (int pass = 0; pass < 2 && n == m && m > 1; ++pass)
+    {
+        const int nb_prev = nb_free;
+        int k = 0;
+
+        nb_free = 0;
+
+        while (k < nb_prev)
+        {
+            const int i = free_rows[k++];
+
+            // smallest and second smallest reduced costs of row i
+            int64_t u_min = S[i*m] - v[0];
+            int64_t u_sub = big;
+            int j1 = 0, j2 = 0;
+
+            for (int j = 1; j < m; ++j)
+            {
+                const int64_t h = S[i*m + j] - v[j];
+
+                if (h < u_sub)
+                {
+                    if (h >= u_min)
+                    {
+                        u_sub = h;
+                        j2 = j;
+                    }
+                    else
+                    {
+                        u_sub = u_min;
+                        u_min = h;
+                        j2 = j1;
+                        j1 = j;
+                    }
+                }
+            }
+
+            int i0 = colsol[j1];
+
+            if (u_min < u_sub)
+            {
+                v[j1] -= u_sub - u_min;
+            }
+            else if (i0 >= 0)
+            {
+                j1 = j2;
+                i0 = colsol[j2];
+            }
+
+            rowsol[i] = j1;
+            colsol[j1] = i;
+
+            // the displaced row bids again right away if j1 got cheaper, later otherwise
+            if (i0 >= 0)
+            {
+                if (u_min < u_sub)
+                    free_rows[--k] = i0;
+                else
+                    free_rows[nb_free++] = i0;
+            }
+        }
+    }
+
+    augment(m, nb_free);
+
+    return reduce(C, n, m);
+}
+
+
+template <typename T>
+T JVSolver<T>::complete (T* C, int n, int m, const int64_t* prices, const int* assignment)
+{
+    load(C, n, m);
+
+    const int64_t* S = costs.data();
+
+    // columns out of the assignment start at 0
+    std::fill(v.begin(), v.begin() + m, 0);
+
+    for (int i = 0; i < n; ++i)
+    {
+        if (assignment[i] >= 0)
+            v[assignment[i]] = -prices[assignment[i]];
+    }
+
+    int nb_free;
+    bool changed = true;
+
+    // keep the tight assigned edges, the columns left free getting back to 0 until none is
+    while (changed)
+    {
+        std::fill(colsol.begin(), colsol.begin() + m, -1);
+
+        nb_free = 0;
+
+        for (int i = 0; i < n; ++i)
+        {
+            int64_t u = S[i*m] - v[0];
+
+            for (int j = 1; j < m; ++j)
+                u = std::min(u, S[i*m + j] - v[j]);
+
+            const int j = assignment[i];
+
+            if (j >= 0 && S[i*m + j] - v[j] == u && colsol[j] < 0)
+            {
+                rowsol[i] = j;
+                colsol[j] = i;
+            }
+            else
+            {
+                free_rows[nb_free++] = i;
+            }
+        }
+
+        changed = false;
+
+        for (int j = 0; j < m && n < m; ++j)
+        {
+            if (colsol[j] < 0 && v[j] != 0)
+            {
+                v[j] = 0;
+                changed = true;
+            }
+        }
+    }
+
+    augment(m, nb_free);
+
+    return reduce(C, n, m);
+}
+
+
+template <typename T>
+void JVSolver<T>::augment (int m, int nb_free)
+{
+    const int64_t* S = costs.data();
+
+    for (int f = 0; f < nb_free; ++f)
+    {
+        const int free_row = free_rows[f];
+
+        // Dijkstra from free_row until an unassigned column enters the shortest path tree
+        for (int j = 0; j < m; ++j)
+        {
+            d[j] = S[free_row*m + j] - v[j];
+            pred[j] = free_row;
+            collist[j] = j;
+        }
+
+        // collist[0..low-1] are scanned, collist[low..up-1] at the current minimum, the others to come
+        int low = 0, up = 0, last = 0, end_of_path = -1;
+        int64_t min = 0;
+
+        while (end_of_path < 0)
+        {
+            if (up == low)
+            {
+                last = low - 1;
+
+                // columns reaching the new minimum
+                min = d[collist[up++]];
+
+                for (int k = up; k < m; ++k)
+                {
+                    const int j = collist[k];
+                    const int64_t h = d[j];
+
+                    if (h <= min)
+                    {
+                        if (h < min)
+                        {
+                            up = low;
+                            min = h;
+                        }
+
+                        collist[k] = collist[up];
+                        collist[up++] = j;
+                    }
+                }
+
+                for (int k = low; k < up; ++k)
+                {
+                    if (colsol[collist[k]] < 0)
+                    {
+                        end_of_path = collist[k];
+                        break;
+                    }
+                }
+            }
+
+            if (end_of_path < 0)
+            {
+                // scan the next column at the minimum, through the row assigned to it
+                const int j1 = collist[low++];
+                const int i = colsol[j1];
+                const int64_t h = S[i*m + j1] - v[j1] - min;
+
+                for (int k = up; k < m; ++k)
+                {
+                    const int j = collist[k];
+                    const int64_t d_new = S[i*m + j] - v[j] - h;
+
+                    if (d_new < d[j])
+                    {
+                        pred[j] = i;
+
+                        if (d_new == min)
+                        {
+                            if (colsol[j] < 0)
+                            {
+                                end_of_path = j;
+                                break;
+                            }
+
+                            collist[k] = collist[up];
+                            collist[up++] = j;
+                        }
+
+                        d[j] = d_new;
+                    }
+                }
+            }
+        }
+
+        // update potentials of the scanned columns
+        for (int k = 0; k <= last; ++k)
+        {
+            const int j1 = collist[k];
+            v[j1] += d[j1] - min;
+        }
+
+        // augment along the alternating path
+        int i;
+
+        do
+        {
+            i = pred[end_of_path];
+            colsol[end_of_path] = i;
+            std::swap(end_of_path, rowsol[i]);
+        }
+        while (i != free_row);
+    }
+}
+
+
+template <typename T>
+T JVSolver<T>::reduce (T* C, int n, int m)
+{
+    const int64_t* S = costs.data();
+
+    // compute total cost
+    T total_cost = 0;
+
+    for (int i = 0; i < n; ++i)
+        total_cost += C[i*m + rowsol[i]];
+
+    // reduced costs of the first n rows, the row potentials following from the tight assigned edges
+    for (int i = 0; i < n; ++i)
+    {
+        const int64_t u = S[i*m + rowsol[i]] - v[rowsol[i]];
+
+        for (int j = 0; j < m; ++j)
+        {
+            const int64_t reduced = S[i*m + j] - u - v[j];
+
+            assert(reduced >= 0 && "Error: Infeasible LAP potentials.");
+
+            if (reduced > std::numeric_limits<T>::max())
+            {
+                cerr << "Error: cost overflow (reduced cost " << reduced << "), use a wider cost type (--cost-type)" << endl;
+                exit(1);
+            }
+
+            C[i*m + j] = T(reduced);
+        }
+    }
+
+    return total_cost;
+}
+
+
+//----------------------------------- Auction -----------------------------------//
+
+template <typename T>
+AuctionSolver<T>& AuctionSolver<T>::Local ()
+{
+    static thread_local AuctionSolver solver;
+    return solver;
+}
+
+
+template <typename T>
+void AuctionSolver<T>::reserve (int m)
+{
+    if ((int)prices.size() < m)
+    {
+        prices.resize(m);
+        potentials.resize(m);
+        owner.resize(m);
+        assignment.resize(m);
+        unassigned.resize(m);
+        next_unassigned.resize(m);
+        bid_object.resize(m);
+        bid_price.resize(m);
+        winner.resize(m);
+    }
+}
+
+
+template <typename T>
+T AuctionSolver<T>::solve (T* C, int n, int m)
+{
+    // bids need two columns
+    if (m == 1)
+        return JVSolver<T>::Local().solve(C, n, m);
+
+    reserve(m);
+
+    // person i values object j at -scale*C[i][j] - prices[j], the m - n padded rows at -prices[j]
+    const int64_t scale = m + 1;
+
+    T c_min = 0, c_max = 0;
+
+    for (int x = 0; x < n*m; ++x)
+    {
+        c_min = std::min(c_min, C[x]);
+        c_max = std::max(c_max, C[x]);
+    }
+
+    int64_t eps = std::max<int64_t>(1, scale*(int64_t(c_max) - c_min) / 8);
+
+    std::fill(prices.begin(), prices.begin() + m, 0);
+
+    const bool parallel = (m >= PARALLEL_SIZE) && !omp_in_parallel();
+
+    int* unassigned_ptr = unassigned.data();
+    int* bid_object_ptr = bid_object.data();
+    int64_t* bid_price_ptr = bid_price.data();
+    const int64_t* prices_ptr = prices.data();
+
+    while (true)
+    {
+        // each phase restarts from an empty assignment, the prices being kept
+        std::fill(owner.begin(), owner.begin() + m, -1);
+        std::fill(assignment.begin(), assignment.begin() + m, -1);
+        std::fill(winner.begin(), winner.begin() + m, -1);
+
+        for (int i = 0; i < m; ++i)
+            unassigned[i] = i;
+
+        int nb_unassigned = m;
+
+        // Gauss-Seidel rounds: one bidder at a time, the next one seeing the new price
+        while (!parallel && nb_unassigned > 0)
+        {
+            const int i = unassigned[--nb_unassigned];
+
+            int64_t best = std::numeric_limits<int64_t>::min();
+            int64_t second = std::numeric_limits<int64_t>::min();
+            int j_best = 0;
+
+            for (int j = 0; j < m; ++j)
+            {
+                const int64_t value = ((i < n) ? -scale*C[i*m + j] : 0) - prices[j];
+
+                if (value > best)
+                {
+                    second = best;
+                    best = value;
+                    j_best = j;
+                }
+                else if (value > second)
+                {
+                    second = value;
+                }
+            }
+
+            if (owner[j_best] >= 0)
+            {
+                assignment[owner[j_best]] = -1;
+                unassigned[nb_unassigned++] = owner[j_best];
+            }
+
+            owner[j_best] = i;
+            assignment[i] = j_best;
+            prices[j_best] += best - second + eps;
+        }
+
+        // Jacobi rounds: all the unassigned persons bid at once
+        while (nb_unassigned > 0)
+        {
+            // bids of the unassigned persons, against the prices of the round
+            #pragma omp parallel for default(none) shared(C, n, m, scale, eps, nb_unassigned, unassigned_ptr, bid_object_ptr, bid_price_ptr, prices_ptr) if (parallel)
+            for (int k = 0; k < nb_unassigned; ++k)
+            {
+                const int i = unassigned_ptr[k];
+
+                int64_t best = std::numeric_limits<int64_t>::min();
+                int64_t second = std::numeric_limits<int64_t>::min();
+                int j_best = 0;
+
+                for (int j = 0; j < m; ++j)
+                {
+                    const int64_t value = ((i < n) ? -scale*C[i*m + j] : 0) - prices_ptr[j];
+
+                    if (value > best)
+                    {
+                        second = best;
+                        best = value;
+                        j_best = j;
+                    }
+                    else if (value > second)
+                    {
+                        second = value;
+                    }
+                }
+
+                bid_object_ptr[k] = j_best;
+                bid_price_ptr[k] = prices_ptr[j_best] + best - second + eps;
+            }
+
+            // each object goes to its highest bidder, the first one on ties
+            for (int k = 0; k < nb_unassigned; ++k)
+            {
+                const int j = bid_object[k];
+
+                if (winner[j] < 0 || bid_price[k] > bid_price[winner[j]])
+                    winner[j] = k;
+            }
+
+            int nb_next = 0;
+
+            for (int k = 0; k < nb_unassigned; ++k)
+            {
+                const int i = unassigned[k];
+                const int j = bid_object[k];
+
+                if (winner[j] != k)
+                {
+                    next_unassigned[nb_next++] = i;
+                    continue;
+                }
+
+                if (owner[j] >= 0)
+                {
+                    assignment[owner[j]] = -1;
+                    next_unassigned[nb_next++] = owner[j];
+                }
+
+                owner[j] = i;
+                assignment[i] = j;
+                prices[j] = bid_price[k];
+            }
+
+            for (int k = 0; k < nb_unassigned; ++k)
+                winner[bid_object[k]] = -1;
+
+            std::copy(next_unassigned.begin(), next_unassigned.begin() + nb_next, unassigned.begin());
+            nb_unassigned = nb_next;
+        }
+
+        if (eps == 1)
+            break;
+
+        eps = std::max<int64_t>(1, eps / 4);
+    }
+
+    // prices in the units of C, the rounding leaving some assigned edges loose
+    for (int j = 0; j < m; ++j)
+        potentials[j] = prices[j] / scale;
+
+    return JVSolver<T>::Local().complete(C, n, m, potentials.data(), assignment.data());
+}
+
+
+template class JVSolver<int16_t>;
+template class JVSolver<int32_t>;
+template class JVSolver<int64_t>;
+
+template class AuctionSolver<int16_t>;
+template class AuctionSolver<int32_t>;
+template class AuctionSolver<int64_t>;
+
+template int16_t LAP::Solve (LAPBackend, int16_t*, int, int);
+template int32_t LAP::Solve (LAPBackend, int32_t*, int, int);
+template int64_t LAP::Solve (LAPBackend, int64_t*, int, int);
+
+template int16_t LAP::SolveLeader (int16_t*, int, int, int64_t);
+template int32_t LAP::SolveLeader (int32_t*, int, int, int64_t);
+template int64_t LAP::SolveLeader (int64_t*, int, int, int64_t);
@@ -1,6 +1,10 @@
 #include "../include/node.hpp"
+#include "../include/compact.hpp"
+#include "../include/spill.hpp"
+#include "../include/search.hpp"
 #include "../include/heuristics.hpp"
 #include "../include/objective.hpp"
+#include "../include/lap.hpp"
 
 
 // ARGUMENTS:
@@ -9,14 +13,269 @@
 // argv[3] = it_max                           (optional, default: 5)
 // argv[4] = sequential or parallel bounding  (optional, default: true)
 
+// OPTIONS:
+// --rect=<0|1>         rectangular n×m cost tensor instead of padding to m×m  (default: 0)
+// --hugepages=<0|1>    back the large cost tensors with huge pages            (default: 0)
+// --cost-type=<auto|16|32|64>  width of the cost entries, auto picks the narrowest safe one  (default: auto)
+// --compact=<0|1>      pool of compact nodes, cost matrices replayed from cached ancestors (default: 0)
+// --mem-limit=<MB>     memory budget of the pool, the deepest nodes being spilled to disk beyond it, 0 for none (default: 0)
+// --lap-blocks=<hungarian|jv|auction>  LAP backend of the blocks  (default: hungarian)
+// --lap-leader=<hungarian|jv|auction>  LAP backend of the leader  (default: hungarian)
+// --warm=<0|1>         warm-start the block LAPs from the assignments of the previous iteration or of the parent (default: 0)
+// --fixing=<0|1>      reduced-cost fixing of the bounded nodes, the assignments beyond the best cost being raised (default: 0)
+// --cascade=<none|leader,glb>  cheap bounds tried in order before the iterative one: the leader LAP, the Gilmore-Lawler bound (default: none)
+// --it-schedule=<none|b0,b1,...>  iteration budgets of the nodes by depth, the last one holding deeper, instead of it_max (default: none)
+// --min-gain=<x>       stop iterating once an iteration gains less than x times the gap left to the best cost (default: 0)
+// --gap-stop=<0|1>     stop iterating once repeating the last gain over the remaining budget could not prune the node (default: 0)
+// --child-order=<index|bound>  children explored by physical qubit index, or by lower bound then closeness to the taken qubits (default: index)
+// --branching=<static|regret|fewest>  logical qubit to branch on: next in the priority order, of largest regret in the node's leader, or with the fewest surviving children (default: static)
+// --siblings=<0|1>     bound the children of a decomposition together, as soon as they are generated (default: 0)
+// --search=<dfs|best|hybrid>  exploration order: depth-first, best-first on the lower bounds, or depth-first dives restarted from the best bound (default: dfs)
+// --dive=<n>           pops between two restarts of the hybrid search from the best bound (default: 64)
+// --queue-limit=<MB>   memory cap of the best-first queue, the search falling back to depth-first beyond it, 0 for none (default: 0)
+// --progress=<n>       print the best cost and the global lower bound every n visited nodes, 0 for never (default: 0)
+
+
+/* exploration of the B&B tree in the order of the search strategy, the cost matrices holding entries of type T */
+template <typename T>
+void Explore (const vector<vector<int>>& D, const vector<vector<int>>& F, int n, int m, const vector<int>& priority, const BoundingOptions& options,
+              int it_max, bool bound_par, bool rectangular, int& min_cost, vector<vector<int>>& optimal_solutions, double& nb_nodes_visited,
+              double& bound_iter_sum, double& nb_nodes_bounded, double& rt_bound, size_t mem_limit, bool warm_start, bool siblings, Strategy strategy,
+              int dive, size_t queue_limit, int progress)
+{
+    int it;
+    vector<int> its;
+
+    // children of the last decomposition, moved into the pool
+    vector<Node<T>> children;
+
+    // one cost tensor per depth of the DFS, recycled instead of reallocated
+    Arena::Reserve(rectangular ? n : m, m, n, sizeof(T));
+
+    SearchPool<Node<T>> Pool(strategy, mem_limit, queue_limit, dive);
+    Pool.push(Node<T>::Root(D, F, n, m, rectangular, warm_start));
+
+    // TEST //
+    /*
+    std::cout << F << std::endl;
+    std::cout << D << std::endl;
+    Node<T> root0 = Node<T>::Root(D, F, n, m);
+    std::cout << root0.get_costMatrix() << std::endl;
+    */
+    //////////
+
+    while (!Pool.empty())
+    {
+        // ordered by bound, the open nodes are all pruned once the best of them exceeds the best cost
+        if (strategy != Strategy::DepthFirst && Pool.get_lowerBound() > min_cost)
+        {
+            break;
+        }
+
+        // extract next node
+        Node<T> node = Pool.pop();
+
+        ++ nb_nodes_visited;
+
+        // optimality gap, the extracted node still counting as open, the nodes above the best cost
+        // being already pruned
+        if (progress > 0 && (long)nb_nodes_visited % progress == 0)
+        {
+            const int lb_open = std::min({Pool.get_lowerBound(), node.get_lowerBound(), min_cost});
+
+            std::cout << "visited = " << nb_nodes_visited << ", open = " << Pool.size() + 1 << ", best cost = " << min_cost
+                      << ", lower bound = " << lb_open << ", gap = " << 100.0 * (min_cost - lb_open) / std::max(min_cost, 1) << " %" << std::endl;
+        }
+
+        // leaf node
+        if (node.isLeaf(n))
+        {
+            const vector<int>& map = node.get_solution().mapping;
+            int cost = ObjectiveFunction(map, D, F, n);
+
+            if (cost < min_cost)
+            {
+                optimal_solutions = {map};
+                min_cost = cost;
+            }
+            else if (cost == min_cost)
+            {
+                optimal_solutions.push_back(map);
+            }
+
+            continue;
+        }
+
+        // pruning before bounding, the best cost having possibly improved since the node was pushed
+        if (node.get_lowerBound() > min_cost)
+        {
+            continue;
+        }
+
+        // bounding, unless done along with the node's siblings
+        int lb;
+
+        if (node.isBounded())
+        {
+            lb = node.get_lowerBound();
+        }
+        else
+        {
+            if (bound_par)
+            {
+                lb = node.bound_OMP(options, it_max, min_cost, it, true, rt_bound);
+            }
+            else
+            {
+                lb = node.bound(options, it_max, min_cost, it, true, rt_bound);
+            }
+
+            ++ nb_nodes_bounded;
+            bound_iter_sum += it;
+        }
+
+        // pruning
+        if (lb > min_cost)
+        {
+            continue;
+        }
+
+        // decomposition
+        node.decompose(options, priority, n, m, min_cost, children);
+
+        if (siblings)
+        {
+            Node<T>::BoundSiblings(options, children, it_max, min_cost, true, bound_par, its, rt_bound);
+
+            for (int x : its)
+            {
+                if (x >= 0)
+                {
+                    ++ nb_nodes_bounded;
+                    bound_iter_sum += x;
+                }
+            }
+        }
+
+        // append in Pool
+        for (Node<T>& child : children)
+            Pool.push(std::move(child));
+    }
+
+    if (mem_limit > 0)
+        std::cout << "spilled segments = " << Pool.get_spills() << ", reloaded = " << Pool.get_reloads() << std::endl;
+    if (queue_limit > 0 && strategy != Strategy::DepthFirst)
+        std::cout << "depth-first fallbacks = " << Pool.get_fallbacks() << std::endl;
+}
+
+
+/* same exploration, the pool holding compact nodes whose cost matrices are replayed from their cached ancestors */
+template <typename T>
+void ExploreCompact (const vector<vector<int>>& D, const vector<vector<int>>& F, int n, int m, const vector<int>& priority, const BoundingOptions& options,
+                     int it_max, bool bound_par, bool rectangular, int& min_cost, vector<vector<int>>& optimal_solutions, double& nb_nodes_visited,
+                     double& bound_iter_sum, double& nb_nodes_bounded, double& rt_bound, size_t mem_limit, bool warm_start)
+{
+    int it;
+
+    // children of the last decomposition, copied into the pool
+    vector<CompactNode> children;
+
+    // one cost tensor per depth of the DFS, recycled instead of reallocated
+    Arena::Reserve(rectangular ? n : m, m, n, sizeof(T));
+
+    Node<T> root = Node<T>::Root(D, F, n, m, rectangular, warm_start);
+    ReplayCache<T> cache(std::move(root.get_costMatrix()), priority, n, m);
+
+    SpillPool<CompactNode> Pool(mem_limit);
+    Pool.push_back(CompactNode::Root(m));
+
+    while (!Pool.empty())
+    {
+        // extract next node
+        CompactNode cnode = Pool.back();
+        Pool.pop_back();
+
+        ++ nb_nodes_visited;
+
+        // leaf node
+        if (cnode.isLeaf(n))
+        {
+            vector<int> map = cnode.mapping(priority, n);
+            int cost = ObjectiveFunction(map, D, F, n);
+
+            if (cost < min_cost)
+            {
+                optimal_solutions = {map};
+                min_cost = cost;
+            }
+            else if (cost == min_cost)
+            {
+                optimal_solutions.push_back(map);
+            }
+
+            continue;
+        }
+
+        // pruning before rebuilding the cost matrix
+        if (cnode.lower_bound > min_cost)
+        {
+            continue;
+        }
+
+        // bounding
+        Node<T> node = cache.replay(cnode);
+        int lb;
+
+        if (bound_par)
+        {
+            lb = node.bound_OMP(options, it_max, min_cost, it, true, rt_bound);
+        }
+        else
+        {
+            lb = node.bound(options, it_max, min_cost, it, true, rt_bound);
+        }
+
+        ++ nb_nodes_bounded;
+        bound_iter_sum += it;
+
+        // pruning
+        if (std::max(lb, cnode.lower_bound) > min_cost)
+        {
+            continue;
+        }
+
+        // decomposition, the bounded cost matrix being cached for the children
+        cache.store(cnode, std::move(node.get_costMatrix()), lb);
+
+        CompactChildren(options, cnode, cache.get_costMatrix(cnode.size), lb, priority, n, m, min_cost, children);
+
+        // append in Pool
+        for (const CompactNode& child : children)
+            Pool.push_back(CompactNode(child));
+    }
+
+    std::cout << "replayed reductions = " << cache.get_replays() << std::endl;
+
+    if (mem_limit > 0)
+        std::cout << "spilled segments = " << Pool.get_spills() << ", reloaded = " << Pool.get_reloads() << std::endl;
+}
+
 
 int main (int argc, char** argv)
 {
     
     //----------------------------------- Parameterization -----------------------------------//
 
+    vector<string> args = PositionalArguments(argc, argv);
+
+    // the options of the program, an unknown one being rejected instead of ignored
+    vector<string> option_names = BoundingOptions::OptionNames();
+    option_names.insert(option_names.end(), {"rect", "hugepages", "cost-type", "compact", "mem-limit", "lap-blocks", "lap-leader", "warm", "siblings",
+                                             "search", "dive", "queue-limit", "progress"});
+    CheckOptions(argc, argv, option_names);
+
     // assertion
-    if (argc < 3)
+    if (args.size() < 2)
     {
         std::cerr << "Error: two arguments are required\n";
         std::cerr << "(1): interaction matrix path\n";
@@ -25,35 +284,149 @@ int main (int argc, char** argv)
     }
 
     // distance matrix & physical qubits
-    string distance_matrix_path = argv[2];
+    string distance_matrix_path = args[1];
     vector<vector<int>> D;
     int m = Load_distanceMatrix(D, distance_matrix_path);
 
     // interaction matrix & logical qubits
-    string interaction_matrix_path = argv[1];
+    string interaction_matrix_path = args[0];
     vector<vector<int>> F;
     int n = Load_interactionMatrix(F, interaction_matrix_path, m);
 
     // maximal number of bounding iterations
     int it_max = 5;
-    if (argc > 3)
+    if (args.size() > 2)
     {
-        it_max = std::stoi(argv[3]);
+        it_max = std::stoi(args[2]);
     }
 
     // sequential or parallel bounding
     bool bound_par = true;
-    if (argc > 4)
+    if (args.size() > 3)
+    {
+        bound_par = static_cast<bool>(std::stoi(args[3]));
+    }
+
+    // rectangular (n×m) or square (m×m) cost tensor
+    bool rectangular = static_cast<bool>(std::stoi(OptionalArgument(argc, argv, "rect", "0")));
+
+    // huge pages backing of the cost tensors
+    bool huge_pages = static_cast<bool>(std::stoi(OptionalArgument(argc, argv, "hugepages", "0")));
+
+    // width of the cost matrices entries
+    string cost_type = OptionalArgument(argc, argv, "cost-type", "auto");
+    int cost_bits = (cost_type == "auto") ? CostTypeBits(D, F, n) : std::stoi(cost_type);
+
+    if (cost_bits != 16 && cost_bits != 32 && cost_bits != 64)
+    {
+        std::cerr << "Error: --cost-type must be auto, 16, 32 or 64" << std::endl;
+        exit(1);
+    }
+
+    // memory budget of the pool
+    size_t mem_limit = std::stoul(OptionalArgument(argc, argv, "mem-limit", "0")) << 20;
+
+    // LAP backends of the bounding
+    LAPBackend lap_blocks = LAP::Parse(OptionalArgument(argc, argv, "lap-blocks", "hungarian"));
+    LAPBackend lap_leader = LAP::Parse(OptionalArgument(argc, argv, "lap-leader", "hungarian"));
+
+    // warm-started block LAPs
+    bool warm_start = static_cast<bool>(std::stoi(OptionalArgument(argc, argv, "warm", "0")));
+
+    // reduced-cost fixing, bound cascade, bounding schedule, order of the children and branching variable selection
+    BoundingOptions options = BoundingOptions::Parse(argc, argv, D);
+
+    // compact pool nodes
+    bool compact = static_cast<bool>(std::stoi(OptionalArgument(argc, argv, "compact", "0")));
+
+    // sibling batch bounding
+    bool siblings = static_cast<bool>(std::stoi(OptionalArgument(argc, argv, "siblings", "0")));
+
+    // search strategy
+    Strategy strategy = ParseStrategy(OptionalArgument(argc, argv, "search", "dfs"));
+    int dive = std::stoi(OptionalArgument(argc, argv, "dive", "64"));
+    size_t queue_limit = std::stoul(OptionalArgument(argc, argv, "queue-limit", "0")) << 20;
+    int progress = std::stoi(OptionalArgument(argc, argv, "progress", "0"));
+
+    if (compact && strategy != Strategy::DepthFirst)
+    {
+        std::cerr << "Error: --search=" << StrategyName(strategy) << " requires the regular pool, compact nodes being replayed in depth-first order" << std::endl;
+        exit(1);
+    }
+
+    if (compact && options.branching != Branching::Static)
+    {
+        std::cerr << "Error: --branching=" << BoundingOptions::Name(options.branching) << " requires the regular pool, compact nodes being replayed along the priority order" << std::endl;
+        exit(1);
+    }
+
+    if (compact && siblings)
     {
-        bound_par = static_cast<bool>(std::stoi(argv[4]));
+        std::cerr << "Error: --siblings=1 requires the regular pool, compact nodes being bounded from their replayed matrices" << std::endl;
+        exit(1);
+    }
+
+    if (compact && progress > 0)
+    {
+        std::cerr << "Error: --progress requires the regular pool, the lower bounds of the compact nodes not being tracked" << std::endl;
+        exit(1);
+    }
+
+    if (compact && m > MAX_QUBITS)
+    {
+        std::cerr << "Error: --compact=1 supports at most " << MAX_QUBITS << " physical qubits" << std::endl;
+        exit(1);
     }
 
     // displays
     std::cout << "\nnumber of physical qubits = " << m << "\n";
     std::cout << "number of logical qubits = " << n << std::endl;
     std::cout << "\nit_max = " << it_max << std::endl;
+    if (!options.schedule.empty())
+        std::cout << "iteration budgets by depth = " << options.schedule << std::endl;
+    if (options.min_gain > 0)
+        std::cout << "minimal gain per iteration = " << options.min_gain << " of the gap" << std::endl;
+    if (options.gap_stop)
+        std::cout << "iterations stopped once the gap cannot be closed" << std::endl;
     if (bound_par)
         std::cout << "number of threads = " << omp_get_max_threads() << std::endl;
+    if (rectangular)
+        std::cout << "rectangular cost tensor" << std::endl;
+    if (huge_pages)
+        std::cout << "huge pages enabled" << std::endl;
+    std::cout << "cost type = int" << cost_bits << std::endl;
+    if (compact)
+        std::cout << "compact pool nodes" << std::endl;
+    if (mem_limit > 0)
+        std::cout << "pool memory limit = " << (mem_limit >> 20) << " MB" << std::endl;
+    if (warm_start)
+        std::cout << "warm-started block LAPs" << std::endl;
+    if (options.fixing)
+        std::cout << "reduced-cost fixing" << std::endl;
+    if (siblings)
+        std::cout << "sibling batch bounding" << std::endl;
+    if (options.child_order)
+        std::cout << "children ordered by bound" << std::endl;
+    if (options.branching != Branching::Static)
+        std::cout << "dynamic branching = " << BoundingOptions::Name(options.branching) << std::endl;
+    if (strategy != Strategy::DepthFirst)
+    {
+        std::cout << "search strategy = " << StrategyName(strategy);
+        if (strategy == Strategy::Hybrid)
+            std::cout << ", dives of " << dive << " nodes";
+        if (queue_limit > 0)
+            std::cout << ", queue limit = " << (queue_limit >> 20) << " MB";
+        std::cout << std::endl;
+    }
+    if (!options.cascade.empty())
+    {
+        std::cout << "bound cascade =";
+        for (BoundLevel level : options.cascade)
+            std::cout << " " << BoundingOptions::Name(level);
+        std::cout << " iterative" << std::endl;
+    }
+    if (lap_blocks != LAPBackend::Hungarian || lap_leader != LAPBackend::Hungarian)
+        std::cout << "LAP backends = " << LAP::Name(lap_blocks) << " (blocks), " << LAP::Name(lap_leader) << " (leader)" << std::endl;
 
     // profiling variables
     double rt, rt_bound{0};
@@ -81,81 +454,46 @@ int main (int argc, char** argv)
     double nb_nodes_visited = 0;
     double bound_iter_sum = 0;
     double nb_nodes_bounded = 0;
-    int it;
 
 
     //----------------------------------- B&B tree exploration -----------------------------------//
 
     std::cout << "\n...exploration\n" << std::endl;
 
-    stack<Node> Pool;
-    Pool.push(Node::Root(D, F, n, m));
-
-    // TEST //
-    /*
-    std::cout << F << std::endl;
-    std::cout << D << std::endl;
-    Node root0 = Node::Root(D, F, n, m);
-    std::cout << root0.get_costMatrix() << std::endl;
-    */
-    //////////
+    Arena::UseHugePages(huge_pages);
+    LAP::UseBackends(lap_blocks, lap_leader);
 
-    while (!Pool.empty())
+    switch (cost_bits)
     {
-        // extract next node
-        Node node = Pool.top();
-        Pool.pop();
-
-        ++ nb_nodes_visited;
-
-        // leaf node
-        if (node.isLeaf(n))
-        {
-            const vector<int>& map = node.get_solution().mapping;
-            int cost = ObjectiveFunction(map, D, F, n);
-
-            if (cost < min_cost)
-            {
-                optimal_solutions = {map};
-                min_cost = cost;
-            }
-            else if (cost == min_cost)
-            {
-                optimal_solutions.push_back(map);
-            }
-
-            continue;
-        }
-        
-        // bounding
-        int lb;
-
-        if (bound_par)
-        {
-            lb = node.bound_OMP(it_max, min_cost, it, true, rt_bound);
-        }
-        else
-        {
-            lb = node.bound(it_max, min_cost, it, true, rt_bound);
-        }
-
-        ++ nb_nodes_bounded;
-        bound_iter_sum += it;
-
-        // pruning
-        if (lb > min_cost)
-        {
-            continue;
-        }
-
-        // decomposition
-        vector<Node> children = node.decompose(priority, n, m, min_cost);
-
-        // append in Pool
-        for (Node node : children)
-            Pool.push(node);
+        case 16:
+            if (compact)
+                ExploreCompact<int16_t>(D, F, n, m, priority, options, it_max, bound_par, rectangular, min_cost, optimal_solutions, nb_nodes_visited,
+                                        bound_iter_sum, nb_nodes_bounded, rt_bound, mem_limit, warm_start);
+            else
+                Explore<int16_t>(D, F, n, m, priority, options, it_max, bound_par, rectangular, min_cost, optimal_solutions, nb_nodes_visited,
+                                 bound_iter_sum, nb_nodes_bounded, rt_bound, mem_limit, warm_start, siblings, strategy, dive, queue_limit, progress);
+            break;
+        case 32:
+            if (compact)
+                ExploreCompact<int32_t>(D, F, n, m, priority, options, it_max, bound_par, rectangular, min_cost, optimal_solutions, nb_nodes_visited,
+                                        bound_iter_sum, nb_nodes_bounded, rt_bound, mem_limit, warm_start);
+            else
+                Explore<int32_t>(D, F, n, m, priority, options, it_max, bound_par, rectangular, min_cost, optimal_solutions, nb_nodes_visited,
+                                 bound_iter_sum, nb_nodes_bounded, rt_bound, mem_limit, warm_start, siblings, strategy, dive, queue_limit, progress);
+            break;
+        default:
+            if (compact)
+                ExploreCompact<int64_t>(D, F, n, m, priority, options, it_max, bound_par, rectangular, min_cost, optimal_solutions, nb_nodes_visited,
+                                        bound_iter_sum, nb_nodes_bounded, rt_bound, mem_limit, warm_start);
+            else
+                Explore<int64_t>(D, F, n, m, priority, options, it_max, bound_par, rectangular, min_cost, optimal_solutions, nb_nodes_visited,
+                                 bound_iter_sum, nb_nodes_bounded, rt_bound, mem_limit, warm_start, siblings, strategy, dive, queue_limit, progress);
+            break;
     }
 
+    // the exploration gave every buffer back to the arena
+    Arena::Clear();
+
 
     //----------------------------------- Termination -----------------------------------//
 
@@ -174,7 +512,41 @@ int main (int argc, char** argv)
     const double nb_nodes_total = ComputeTotalNumberOfNodes(n, m);
     std::cout << "\ntotal number of nodes = " << nb_nodes_total << "\n";
     std::cout << "number of visited nodes = " << nb_nodes_visited << "\n";
-    std::cout << "bounding mean iter = " << bound_iter_sum / nb_nodes_bounded << std::endl;
+    std::cout << "bounding mean iter = " << bound_iter_sum / nb_nodes_bounded << "\n";
+    std::cout << "block LAPs solved = " << LAP::get_blockLAPs() << ", zero blocks skipped = " << LAP::get_zeroBlocks() << "\n";
+    std::cout << "leader LAPs stopped early = " << LAP::get_aborted() << std::endl;
+    if (options.fixing)
+        std::cout << "fixed entries = " << Bounding::get_fixed() << std::endl;
+    if (options.branching != Branching::Static)
+        std::cout << "nodes branched off the priority order = " << Bounding::get_reordered() << std::endl;
+
+    // iterations actually run by depth
+    if (!options.schedule.empty() || options.min_gain > 0 || options.gap_stop)
+    {
+        std::cout << "\ndepth \tbudget \tbounded \tmean iter" << std::endl;
+        for (int d = 0; d < n; ++d)
+        {
+            if (Bounding::get_bounded(d) > 0)
+                std::cout << d << " \t" << options.Budget(it_max, d) << " \t" << Bounding::get_bounded(d) << " \t\t"
+                          << Bounding::get_iterations(d) / Bounding::get_bounded(d) << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    // bound cascade pruning
+    if (!options.cascade.empty())
+    {
+        for (BoundLevel level : {BoundLevel::Leader, BoundLevel::GilmoreLawler, BoundLevel::Iterative})
+        {
+            if (Bounding::get_tried(level) > 0)
+                std::cout << BoundingOptions::Name(level) << " bound: " << Bounding::get_tried(level) << " nodes, " << Bounding::get_pruned(level) << " pruned" << std::endl;
+        }
+    }
+
+    // cost buffers allocations
+    std::cout << "\nbuffer allocations = " << Arena::get_allocations() << "\n";
+    std::cout << "buffer reuses = " << Arena::get_reuses() << "\n";
+    std::cout << "node state allocations = " << Arena::get_nodeStates() << " (mapping and availability of each new node)" << std::endl;
 
     // runtime 
     std::cout << "\nruntime = " << rt << " s\n" << std::endl;
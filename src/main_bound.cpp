@@ -1,4 +1,5 @@
 #include "../include/node.hpp"
+#include "../include/lap.hpp"
 
 
 int main()
@@ -40,10 +41,10 @@ int main()
     sol.mapping = map;
     sol.cost = -1;
     vector<bool> available(m, true);
-    CostMatrix CM = CostMatrix::Assemble(D, F, m);
+    CostMatrix<int> CM = CostMatrix<int>::Assemble(D, F, m, m);
 
-    Node root_seq = Node{sol, 0, 0, CM, available};
-    Node root_omp = Node{sol, 0, 0, CM, available};
+    Node<int> root_seq = Node<int>{sol, 0, 0, CM.clone(), available};
+    Node<int> root_omp = Node<int>{sol, 0, 0, std::move(CM), available};
 
 
     // runtime variables
@@ -58,10 +59,13 @@ int main()
     int min_cost = INF;
     int it;
 
+    // default bounding: no fixing, cascade nor schedule
+    const BoundingOptions options;
+
     // sequential
     t0_seq = std::chrono::high_resolution_clock::now();
 
-    lb_seq = root_seq.bound(it_max, min_cost, it, false, rt_dummy);
+    lb_seq = root_seq.bound(options, it_max, min_cost, it, false, rt_dummy);
 
     t1_seq = std::chrono::high_resolution_clock::now();
     delta_seq = t1_seq - t0_seq;
@@ -70,7 +74,7 @@ int main()
     // OpenMP
     t0_omp = std::chrono::high_resolution_clock::now();
 
-    lb_omp = root_omp.bound_OMP(it_max, min_cost, it, false, rt_dummy);
+    lb_omp = root_omp.bound_OMP(options, it_max, min_cost, it, false, rt_dummy);
 
     t1_omp = std::chrono::high_resolution_clock::now();
     delta_omp = t1_omp - t0_omp;
@@ -89,6 +93,65 @@ int main()
     std::cout << "\nruntime seq: \t" << rt_seq << " s\n";
     std::cout << "speedup OMP: \t" << rt_seq / rt_omp << "\n";
 
+
+    //-------------------- LAP backends --------------------//
+
+    // each backend solves the blocks and the leader of the root tensor, then bounds the root at both call sites
+    const LAPBackend backends[] = {LAPBackend::Hungarian, LAPBackend::JonkerVolgenant, LAPBackend::Auction};
+
+    CostMatrix<int> CM_lap = CostMatrix<int>::Assemble(D, F, m, m);
+    const int block_size = CM_lap.get_blockSize();
+
+    int blocks_opt = -1, leader_opt = -1;
+
+    std::cout << "\nLAP backend \tblocks \t\tleader \t\tbound \t\tlb\n";
+
+    for (LAPBackend backend : backends)
+    {
+        CostMatrix<int> CM_b = CM_lap.clone();
+        CM_b.materialize();
+
+        int* C = CM_b.get_costs();
+        int* L = CM_b.get_leader();
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        int blocks_sum = 0;
+        for (int idx = 0; idx < m*m; ++idx)
+            blocks_sum += LAP::Solve(backend, C + idx*block_size, m - 1, m - 1);
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        int leader_cost = LAP::Solve(backend, L, m, m);
+
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        // every backend reaches the same optimal costs
+        if (blocks_opt < 0)
+        {
+            blocks_opt = blocks_sum;
+            leader_opt = leader_cost;
+        }
+        assert(blocks_sum == blocks_opt && leader_cost == leader_opt && "Error: LAP backend failure.");
+
+        LAP::UseBackends(backend, backend);
+
+        Node<int> root_lap = Node<int>{sol, 0, 0, CM_lap.clone(), available};
+
+        auto t3 = std::chrono::high_resolution_clock::now();
+
+        int lb_lap = root_lap.bound(options, it_max, min_cost, it, false, rt_dummy);
+
+        auto t4 = std::chrono::high_resolution_clock::now();
+
+        std::chrono::duration<double> rt_blocks = t1 - t0, rt_leader = t2 - t1, rt_lap = t4 - t3;
+
+        std::cout << LAP::Name(backend) << " \t" << (LAP::Name(backend).size() < 7 ? "\t" : "") << rt_blocks.count() << " s \t" << rt_leader.count() << " s \t"
+                  << rt_lap.count() << " s \t" << lb_lap << "\n";
+    }
+
+    LAP::UseBackends(LAPBackend::Hungarian, LAPBackend::Hungarian);
+
     std::cout << std::endl;
     
 
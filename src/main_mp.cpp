@@ -1,6 +1,8 @@
 #include "../include/node.hpp"
+#include "../include/spill.hpp"
 #include "../include/heuristics.hpp"
 #include "../include/objective.hpp"
+#include "../include/lap.hpp"
 
 #include <boost/mpi.hpp>
 #include <boost/serialization/vector.hpp>
@@ -13,112 +15,50 @@ namespace mpi = boost::mpi;
 // argv[2] = distance matrix path
 // argv[3] = it_max                     (optional, default: 10)
 
+// OPTIONS:
+// --rect=<0|1>     rectangular n×m cost tensor instead of padding to m×m  (default: 0)
+// --cost-type=<auto|16|32|64>  width of the cost entries, auto picks the narrowest safe one  (default: auto)
+// --lap-blocks=<hungarian|jv|auction>  LAP backend of the blocks  (default: hungarian)
+// --lap-leader=<hungarian|jv|auction>  LAP backend of the leader  (default: hungarian)
+// --warm=<0|1>     warm-start the block LAPs from the assignments of the previous iteration or of the parent (default: 0)
+// --cascade=<none|leader,glb>  cheap bounds tried in order before the iterative one: the leader LAP, the Gilmore-Lawler bound (default: none)
+// --it-schedule=<none|b0,b1,...>  iteration budgets of the nodes by depth, the last one holding deeper, instead of it_max (default: none)
+// --min-gain=<x>   stop iterating once an iteration gains less than x times the gap left to the best cost (default: 0)
+// --gap-stop=<0|1>  stop iterating once repeating the last gain over the remaining budget could not prune the node (default: 0)
+// --child-order=<index|bound>  children explored by physical qubit index, or by lower bound then closeness to the taken qubits (default: index)
+// --branching=<static|regret|fewest>  logical qubit to branch on: next in the priority order, of largest regret in the node's leader, or with the fewest surviving children (default: static)
+// --fixing=<0|1>   reduced-cost fixing of the bounded nodes, the assignments beyond the best cost being raised (default: 0)
+// --mem-limit=<MB>  memory budget of the pool of each process, the deepest nodes being spilled to disk beyond it, 0 for none (default: 0)
+
 // example execution command: (2 nodes, 9 proc per node, 4 threads per proc)
 // mpirun -machinefile \$OAR_NODEFILE -np 18 --map-by ppr:9:node:pe=2 -x OMP_NUM_THREADS=4 ./qapbb_mp inter/rd_14.csv dist/20_boeblingen.csv 15
 
-int main (int argc, char** argv)
+/* distributed exploration of the B&B tree, the cost matrices holding entries of type T */
+template <typename T>
+void Explore (mpi::communicator& world, const vector<vector<int>>& D, const vector<vector<int>>& F, int n, int m, const vector<int>& priority,
+              const BoundingOptions& options, int it_max, bool rectangular, bool warm_start, int min_cost, size_t mem_limit, std::chrono::high_resolution_clock::time_point begin)
 {
-
-    //----------------------------------- MPI initialization -----------------------------------//
-
-    mpi::environment env;
-    mpi::communicator world;
     int rank = world.rank();
     int nb_proc = world.size();
 
     MPI_Comm raw_comm = world;
 
-    // display process->node assignement
-    if (nb_proc <= 64)
-    {
-        char hostname[256];
-        gethostname(hostname, sizeof(hostname));
-        std::cout << "Rank " << rank << " running on [" << hostname << "] and using " << omp_get_max_threads() << " threads" << std::endl;
-    }
-    else if (rank == 0)
-    {
-        std::cout << "\nnumber of processes = " << nb_proc << "\n";
-        std::cout << "number of threads per process = " << omp_get_max_threads() << std::endl;
-    }
-    world.barrier();
-
-
-    //----------------------------------- Variables -----------------------------------//
-
-    // parameter
-    int it_max = 10;
-
-    // initialization variables
-    vector<vector<int>> D, F;
-    vector<int> priority;
-    int n, m, min_cost;
-
     // tree exploration variables
     vector<vector<int>> optimal_solutions;
     Solution sol;
     std::vector<char> send_flags;
-    vector<Node> Pool, initial_tasks, shared;
+    SpillPool<Node<T>> Pool(mem_limit);
+    vector<Node<T>> initial_tasks, shared, children;
     int nb_init_task, lb, it;
-    Node node;
+    Node<T> node;
     double nb_nodes_visited_loc{0};
     double nb_nodes_visited{0};
 
     // profiling variables
-    std::chrono::high_resolution_clock::time_point begin, end;
+    std::chrono::high_resolution_clock::time_point end;
     std::chrono::duration<double> duration;
     double rt, rt_bound{0};
 
-
-    //----------------------------------- Initialization (master) -----------------------------------//
-
-    if (rank == 0)
-    {
-        // assertion
-        if (argc < 3)
-        {
-            std::cerr << "Error: two arguments are required\n";
-            std::cerr << "(1): interaction matrix path\n";
-            std::cerr << "(2): distance matrix path" << std::endl;
-            exit(1);
-        }
-
-        // distance matrix & physical qubits
-        string distance_matrix_path = argv[2];
-        m = Load_distanceMatrix(D, distance_matrix_path);
-
-        // interaction matrix & logical qubits
-        string interaction_matrix_path = argv[1];
-        n = Load_interactionMatrix(F, interaction_matrix_path, m);
-
-        // maximal number of bounding iterations
-        if (argc > 3)
-        {
-            it_max = std::stoi(argv[3]);
-        }
-        
-        // displays
-        std::cout << "\nnumber of physical qubits = " << m << "\n";
-        std::cout << "number of logical qubits = " << n << std::endl;
-        std::cout << "\nit_max = " << it_max << std::endl;
-
-        // START TIMER //
-        begin = std::chrono::high_resolution_clock::now();
-
-        // prioritization queue of logical qubits
-        priority = Prioritization(F, n, m);
-
-        // greedy heuristic allocation
-        vector<int> map0;
-        min_cost = GreedyAllocation(D, F, priority, n, m, map0);
-    }
-
-    mpi::broadcast(world, m, 0);
-    mpi::broadcast(world, n, 0);
-    mpi::broadcast(world, priority, 0);
-    mpi::broadcast(world, min_cost, 0);
-    mpi::broadcast(world, D, 0);
-    mpi::broadcast(world, F, 0);
-
     // tags
     const int TAG_WORK_SHARING = 10;
     const int TAG_SEND_SOLUTION = 20;
@@ -130,11 +70,11 @@ int main (int argc, char** argv)
     {
         std::cout << "\n...exploration\n" << std::endl;
 
-        Node root = Node::Root(D, F, n, m);
+        Node<T> root = Node<T>::Root(D, F, n, m, rectangular, warm_start);
 
-        lb = root.bound_OMP(it_max, min_cost, it, true, rt_bound);
+        lb = root.bound_OMP(options, it_max, min_cost, it, true, rt_bound);
 
-        initial_tasks = root.decompose(priority, n, m, min_cost);
+        root.decompose(options, priority, n, m, min_cost, initial_tasks);
 
         nb_init_task = initial_tasks.size();
 
@@ -151,19 +91,19 @@ int main (int argc, char** argv)
             int rank_dest = i % nb_proc;
 
             if (rank_dest == 0)
-                Pool.push_back(initial_tasks[i]);
+                Pool.push_back(std::move(initial_tasks[i]));
             else
                 world.send(rank_dest, TAG_WORK_SHARING, initial_tasks[i]);
         }
     }
     else
     {
-        Node task;
+        Node<T> task;
 
         for (int i = 0; i < nb_init_task_loc; ++i)
         {
             world.recv(0, TAG_WORK_SHARING, task);
-            Pool.push_back(task);
+            Pool.push_back(std::move(task));
         }
     }
 
@@ -180,7 +120,7 @@ int main (int argc, char** argv)
 
         if (!empty)
         {
-            node = Pool.back();
+            node = std::move(Pool.back());
             Pool.pop_back();
 
             ++ nb_nodes_visited_loc;
@@ -307,7 +247,7 @@ int main (int argc, char** argv)
         if (!skip)
         {
             // bounding
-            lb = node.bound_OMP(it_max, min_cost, it, true, rt_bound);
+            lb = node.bound_OMP(options, it_max, min_cost, it, true, rt_bound);
 
             // bounding
             if (lb > min_cost)
@@ -320,11 +260,11 @@ int main (int argc, char** argv)
         //----- decomposition -----//
         if (!skip)
         {
-            vector<Node> children = node.decompose(priority, n, m, min_cost);
+            node.decompose(options, priority, n, m, min_cost, children);
 
             // append in Pool
-            for (Node node : children)
-                Pool.push_back(node);
+            for (Node<T>& child : children)
+                Pool.push_back(std::move(child));
         }
 
 
@@ -362,20 +302,12 @@ int main (int argc, char** argv)
         {
             if (rank == max_pool_rank)
             {
-                auto begin = Pool.begin();
-                auto mid   = Pool.begin() + pool_size / 2;
-
-                // move half of Pool into shared
-                shared.clear();
-                shared.reserve(std::distance(begin, mid));
-                std::move(begin, mid, std::back_inserter(shared));
+                // move half of Pool into shared, from its in-memory nodes only
+                shared = Pool.split_bottom(pool_size / 2);
 
                 // send 'shared' to the empty pool rank
                 world.send(min_pool_rank, TAG_WORK_SHARING, shared);
 
-                // remove elements from Pool
-                Pool.erase(begin, mid);
-
                 pool_size = Pool.size();
             }
 
@@ -385,8 +317,8 @@ int main (int argc, char** argv)
                 world.recv(max_pool_rank, TAG_WORK_SHARING, shared);
 
                 // move received nodes into pool (avoiding copies)
-                Pool.reserve(Pool.size() + shared.size());
-                std::move(shared.begin(), shared.end(), std::back_inserter(Pool));
+                for (Node<T>& task : shared)
+                    Pool.push_back(std::move(task));
                 shared.clear(); // optional
 
                 pool_size = Pool.size();
@@ -439,6 +371,186 @@ int main (int argc, char** argv)
         // runtime
         std::cout << "\nruntime = " << rt << " s\n" << std::endl;
     }
+}
+
+
+int main (int argc, char** argv)
+{
+
+    //----------------------------------- MPI initialization -----------------------------------//
+
+    mpi::environment env;
+    mpi::communicator world;
+    int rank = world.rank();
+    int nb_proc = world.size();
+
+    // display process->node assignement
+    if (nb_proc <= 64)
+    {
+        char hostname[256];
+        gethostname(hostname, sizeof(hostname));
+        std::cout << "Rank " << rank << " running on [" << hostname << "] and using " << omp_get_max_threads() << " threads" << std::endl;
+    }
+    else if (rank == 0)
+    {
+        std::cout << "\nnumber of processes = " << nb_proc << "\n";
+        std::cout << "number of threads per process = " << omp_get_max_threads() << std::endl;
+    }
+    world.barrier();
+
+
+    //----------------------------------- Variables -----------------------------------//
+
+    // parameters
+    int it_max = 10;
+    bool rectangular = false;
+    bool warm_start = false;
+    int lap_blocks = 0, lap_leader = 0;
+    BoundingOptions options;
+    size_t mem_limit = 0;
+
+    // initialization variables
+    vector<vector<int>> D, F;
+    vector<int> priority;
+    int n, m, min_cost, cost_bits;
+
+    // profiling variables
+    std::chrono::high_resolution_clock::time_point begin;
+
+
+    //----------------------------------- Initialization (master) -----------------------------------//
+
+    if (rank == 0)
+    {
+        vector<string> args = PositionalArguments(argc, argv);
+
+        // the options of the program, an unknown one being rejected instead of ignored
+        vector<string> option_names = BoundingOptions::OptionNames();
+        option_names.insert(option_names.end(), {"rect", "cost-type", "lap-blocks", "lap-leader", "warm", "mem-limit"});
+        CheckOptions(argc, argv, option_names);
+
+        // assertion
+        if (args.size() < 2)
+        {
+            std::cerr << "Error: two arguments are required\n";
+            std::cerr << "(1): interaction matrix path\n";
+            std::cerr << "(2): distance matrix path" << std::endl;
+            exit(1);
+        }
+
+        // distance matrix & physical qubits
+        string distance_matrix_path = args[1];
+        m = Load_distanceMatrix(D, distance_matrix_path);
+
+        // interaction matrix & logical qubits
+        string interaction_matrix_path = args[0];
+        n = Load_interactionMatrix(F, interaction_matrix_path, m);
+
+        // maximal number of bounding iterations
+        if (args.size() > 2)
+        {
+            it_max = std::stoi(args[2]);
+        }
+
+        // rectangular (n×m) or square (m×m) cost tensor
+        rectangular = static_cast<bool>(std::stoi(OptionalArgument(argc, argv, "rect", "0")));
+
+        // LAP backends of the bounding, on every process
+        lap_blocks = static_cast<int>(LAP::Parse(OptionalArgument(argc, argv, "lap-blocks", "hungarian")));
+        lap_leader = static_cast<int>(LAP::Parse(OptionalArgument(argc, argv, "lap-leader", "hungarian")));
+
+        // warm-started block LAPs, the assignments travel with the nodes
+        warm_start = static_cast<bool>(std::stoi(OptionalArgument(argc, argv, "warm", "0")));
+
+        // reduced-cost fixing, bound cascade, bounding schedule, order of the children and branching variable selection, on every process
+        options = BoundingOptions::Parse(argc, argv, D);
+
+        // width of the cost matrices entries
+        string cost_type = OptionalArgument(argc, argv, "cost-type", "auto");
+        cost_bits = (cost_type == "auto") ? CostTypeBits(D, F, n) : std::stoi(cost_type);
+
+        if (cost_bits != 16 && cost_bits != 32 && cost_bits != 64)
+        {
+            std::cerr << "Error: --cost-type must be auto, 16, 32 or 64" << std::endl;
+            exit(1);
+        }
+        
+        // memory budget of the pool of each process
+        mem_limit = std::stoul(OptionalArgument(argc, argv, "mem-limit", "0")) << 20;
+
+        // displays
+        std::cout << "\nnumber of physical qubits = " << m << "\n";
+        std::cout << "number of logical qubits = " << n << std::endl;
+        std::cout << "\nit_max = " << it_max << std::endl;
+        if (!options.schedule.empty())
+            std::cout << "iteration budgets by depth = " << options.schedule << std::endl;
+        if (options.min_gain > 0)
+            std::cout << "minimal gain per iteration = " << options.min_gain << " of the gap" << std::endl;
+        if (options.gap_stop)
+            std::cout << "iterations stopped once the gap cannot be closed" << std::endl;
+        if (rectangular)
+            std::cout << "rectangular cost tensor" << std::endl;
+        if (warm_start)
+            std::cout << "warm-started block LAPs" << std::endl;
+        if (options.fixing)
+            std::cout << "reduced-cost fixing" << std::endl;
+        if (options.child_order)
+            std::cout << "children ordered by bound" << std::endl;
+        if (options.branching != Branching::Static)
+            std::cout << "dynamic branching = " << BoundingOptions::Name(options.branching) << std::endl;
+        if (!options.cascade.empty())
+        {
+            std::cout << "bound cascade =";
+            for (BoundLevel level : options.cascade)
+                std::cout << " " << BoundingOptions::Name(level);
+            std::cout << " iterative" << std::endl;
+        }
+        if (lap_blocks != 0 || lap_leader != 0)
+            std::cout << "LAP backends = " << LAP::Name(LAPBackend(lap_blocks)) << " (blocks), " << LAP::Name(LAPBackend(lap_leader)) << " (leader)" << std::endl;
+        std::cout << "cost type = int" << cost_bits << std::endl;
+        if (mem_limit > 0)
+            std::cout << "pool memory limit = " << (mem_limit >> 20) << " MB per process" << std::endl;
+
+        // START TIMER //
+        begin = std::chrono::high_resolution_clock::now();
+
+        // prioritization queue of logical qubits
+        priority = Prioritization(F, n, m);
+
+        // greedy heuristic allocation
+        vector<int> map0;
+        min_cost = GreedyAllocation(D, F, priority, n, m, map0);
+    }
+
+    mpi::broadcast(world, m, 0);
+    mpi::broadcast(world, n, 0);
+    mpi::broadcast(world, priority, 0);
+    mpi::broadcast(world, min_cost, 0);
+    mpi::broadcast(world, D, 0);
+    mpi::broadcast(world, F, 0);
+    mpi::broadcast(world, cost_bits, 0);
+    mpi::broadcast(world, lap_blocks, 0);
+    mpi::broadcast(world, lap_leader, 0);
+    mpi::broadcast(world, options, 0);
+
+    LAP::UseBackends(LAPBackend(lap_blocks), LAPBackend(lap_leader));
+    mpi::broadcast(world, mem_limit, 0);
+
+    switch (cost_bits)
+    {
+        case 16:
+            Explore<int16_t>(world, D, F, n, m, priority, options, it_max, rectangular, warm_start, min_cost, mem_limit, begin);
+            break;
+        case 32:
+            Explore<int32_t>(world, D, F, n, m, priority, options, it_max, rectangular, warm_start, min_cost, mem_limit, begin);
+            break;
+        default:
+            Explore<int64_t>(world, D, F, n, m, priority, options, it_max, rectangular, warm_start, min_cost, mem_limit, begin);
+            break;
+    }
+
+    // the exploration gave every buffer back to the arena
+    Arena::Clear();
 
 
     return 0;
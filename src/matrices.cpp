@@ -1,4 +1,5 @@
 #include "../include/matrices.hpp"
+#include "../include/kernels.hpp"
 
 
 int Load_distanceMatrix (vector<vector<int>>& D, const std::string& file_path)
@@ -123,298 +124,523 @@ vector<vector<int>> LinearCouplingDistanceMatrix (int n)
 }
 
 
-CostMatrix CostMatrix::Assemble (const vector<vector<int>>& D, const vector<vector<int>>& F, int m)
+template <typename T>
+CostMatrix<T> CostMatrix<T>::Assemble (const vector<vector<int>>& D, const vector<vector<int>>& F, int n, int m)
 {
-    vector<int> costs(m*m*m*m, 0);
-    vector<int> leader(m*m, 0);
+    assert(n <= m && "Error: There must be at least as many physical qubits as logical qubits.");
+
+    CostMatrix CM(n, m);
 
-    const int inf = INF / 2;
+    T* costs = CM.get_costs();
+    T* leader = CM.get_leader();
 
     int i, j, k, l;
 
-    for (i = 0; i < m; ++i)
+    for (i = 0; i < n; ++i)
     {
         for (j = 0; j < m; ++j)
         {
-            for (k = 0; k < m; ++k)
+            for (k = 0; k < n; ++k)
             {
+                if (k == i)
+                    continue;
+
                 for (l = 0; l < m; ++l)
                 {
-                    if ((k == i) ^ (l == j))
-                        costs[idx4D(i, j, k, l, m)] = inf;
-                    else
-                        costs[idx4D(i, j, k, l, m)] = F[i][k] * D[j][l];
-
-                    //if (!((k == i) != (l == j)))
-                    //    costs[idx4D(i, j, k, l, m)] = F[i][k] * D[j][l];
+                    if (l != j)
+                        costs[idx4D(i, j, k, l, n, m)] = CheckedProduct<T>(F[i][k], D[j][l]);
                 }
             }
-            leader[i*m + j] = costs[idx4D(i, j, i, j, m)];
+            leader[i*m + j] = CheckedProduct<T>(F[i][i], D[j][j]);
         }
     }
 
-    return CostMatrix{costs, leader, m};
-}
-
+    // the idle logical qubits have all-zero blocks, and all-zero rows in the others' blocks
+    for (i = 0; i < n && i < 64; ++i)
+    {
+        bool idle = true;
 
-void CostMatrix::distributeLeader ()
-{
-    vector<int>& C = this -> costs;
-    vector<int>& L = this -> leader;
-    const int n = this -> size;
+        for (k = 0; k < (int)F.size() && idle; ++k)
+            idle = (F[i][k] == 0 && F[k][i] == 0);
 
-    int i, j, k, l;
-    int leader_cost, leader_cost_div, leader_cost_rem, val;
+        if (idle)
+            CM.zero_rows |= uint64_t(1) << i;
+    }
 
-    if (n == 1)
-    {
-        C[0] = 0;
-        L[0] = 0;
+    return CM;
+}
 
-        return;
-    }
 
-    for (i = 0; i < n; ++i)
-    {
-        for (j = 0; j < n; ++j)
-        {
-            leader_cost = L[i*n + j];
+template <typename T>
+uint64_t CostMatrix<T>::get_zeroRows () const
+{
+    // a nonzero leader entry gets spread over the rows of its block, the halving then moving it to the idle rows' blocks
+    if (zero_rows == 0 || !IsZeroBlock(get_leader(), rows*cols))
+        return 0;
 
-            C[idx4D(i, j, i, j, n)] = 0;
-            L[i*n + j] = 0;
+    return zero_rows;
+}
 
-            if (leader_cost == 0)
-            {
-                continue;
-            }
 
-            leader_cost_div = leader_cost / (n - 1);
-            leader_cost_rem = leader_cost % (n - 1);
+// value added to the local row r of block (i, j) when spreading its leader over the n - 1 other rows
+template <typename T>
+static void LeaderShares (T leader_cost, int i, int n, T* vals)
+{
+    const T leader_cost_div = leader_cost / (n - 1);
+    const T leader_cost_rem = leader_cost % (n - 1);
 
-            for (k = 0; k < n; ++k)
-            {
-                if (k == i)
-                    continue;
+    for (int r = 0; r < n - 1; ++r)
+    {
+        const int k = r + (r >= i);
 
-                val = leader_cost_div + (k < leader_cost_rem || (k == leader_cost_rem && i < k));
-                
-                for (l = 0; l < n; ++l)
-                {
-                    if (l != j)
-                        C[idx4D(i, j, k, l, n)] += val;
-                }
-            }
-        }
+        vals[r] = leader_cost_div + (k < leader_cost_rem || (k == leader_cost_rem && i < k));
     }
 }
 
 
-void CostMatrix::distributeLeader_OMP ()
+template <typename T>
+void CostMatrix<T>::distributeLeader ()
 {
-    vector<int>& C = this -> costs;
-    vector<int>& L = this -> leader;
-    const int n = this -> size;
+    T* C = static_cast<T*>(this -> costs -> data);
+    T* L = static_cast<T*>(this -> leader -> data);
+    const int n = this -> rows;
+    const int m = this -> cols;
 
-    int i, j, k, l;
-    int leader_cost, leader_cost_div, leader_cost_rem, val;
+    int i, j;
+    T leader_cost;
 
+    // a single logical qubit left: the leader cannot be spread over other rows
     if (n == 1)
     {
-        C[0] = 0;
-        L[0] = 0;
-
         return;
     }
 
-    const int nb_threads = std::min(n*n, omp_get_max_threads());
+    // leader shares, scratch of the calling thread
+    static thread_local vector<T> vals;
+    vals.resize(n - 1);
 
-    #pragma omp parallel for collapse(2) default(none) private(i, j, k, l, leader_cost, leader_cost_div, leader_cost_rem, val) \
-            shared(C, L, n) num_threads(nb_threads)
     for (i = 0; i < n; ++i)
     {
-        for (j = 0; j < n; ++j)
+        for (j = 0; j < m; ++j)
         {
-            leader_cost = L[i*n + j];
+            leader_cost = L[i*m + j];
 
-            C[idx4D(i, j, i, j, n)] = 0;
-            L[i*n + j] = 0;
+            L[i*m + j] = 0;
 
             if (leader_cost == 0)
             {
                 continue;
             }
 
-            leader_cost_div = leader_cost / (n - 1);
-            leader_cost_rem = leader_cost % (n - 1);
-
-            for (k = 0; k < n; ++k)
-            {
-                if (k == i)
-                    continue;
+            LeaderShares(leader_cost, i, n, vals.data());
 
-                val = leader_cost_div + (k < leader_cost_rem || (k == leader_cost_rem && i < k));
-                
-                for (l = 0; l < n; ++l)
-                {
-                    if (l != j)
-                        C[idx4D(i, j, k, l, n)] += val;
-                }
-            }
+            // block (i, j) is contiguous, its local rows receiving vals
+            AddRowValues(C + (i*m + j)*(n - 1)*(m - 1), vals.data(), n - 1, m - 1);
         }
     }
 }
 
 
-void CostMatrix::halveComplementary ()
+template <typename T>
+void CostMatrix<T>::halveComplementary ()
 {
-    vector<int>& C = this -> costs;
-    const int n = this -> size;
+    T* C = static_cast<T*>(this -> costs -> data);
+    const int n = this -> rows;
+    const int m = this -> cols;
 
-    int i, j, k, l;
-    int cost_sum;
+    int i, k;
+
+    static thread_local vector<T> tmp;
+    tmp.resize(m - 1);
 
     for (i = 0; i < n; ++i)
     {
-        for (j = 0; j < n; ++j)
+        for (k = i + 1; k < n; ++k)
         {
-            for (k = i; k < n; ++k)
-            {
-                for (l = 0; l < n; ++l)
-                {
-                    if ((k != i) && (l != j))
-                    {
-                        cost_sum = C[idx4D(i, j, k, l, n)] + C[idx4D(k, l, i, j, n)];
-                        C[idx4D(i, j, k, l, n)] = cost_sum / 2;
-                        C[idx4D(k, l, i, j, n)] = cost_sum / 2;
-
-                        if (cost_sum % 2 == 1)
-                        {
-                            if ((i + j + k + l) % 2 == 0) // total index parity for balance
-                                C[idx4D(i, j, k, l, n)] += 1;
-                            else
-                                C[idx4D(k, l, i, j, n)] += 1;
-                        }
-                    }
-                }
-            }
+            HalveRowPair(C, n, m, i, k, tmp.data());
         }
     }
 }
 
 
-void CostMatrix::halveComplementary_OMP ()
+template <typename T>
+int CostMatrix<T>::fixVariables (int lb, int min_cost)
 {
-    vector<int>& C = this -> costs;
-    const int n = this -> size;
+    T* C = static_cast<T*>(this -> costs -> data);
+    T* L = static_cast<T*>(this -> leader -> data);
+    const int n = this -> rows;
+    const int m = this -> cols;
 
-    int i, j, k, l;
-    int cost_sum;
+    const int64_t gap = (int64_t)min_cost - lb;
 
-    const int nb_threads = std::min(n*n, omp_get_max_threads());
+    int nb_fixed = FixLeader(L, n, m, gap);
 
-    #pragma omp parallel for collapse(2) default(none) private(i, j, k, l, cost_sum) shared(C, n) num_threads(nb_threads)
-    for (i = 0; i < n; ++i)
+    for (int i = 0; i < n; ++i)
     {
-        for (j = 0; j < n; ++j)
+        for (int k = i + 1; k < n; ++k)
         {
-            for (k = i; k < n; ++k)
-            {
-                for (l = 0; l < n; ++l)
-                {
-                    if ((k != i) && (l != j))
-                    {
-                        cost_sum = C[idx4D(i, j, k, l, n)] + C[idx4D(k, l, i, j, n)];
-                        C[idx4D(i, j, k, l, n)] = cost_sum / 2;
-                        C[idx4D(k, l, i, j, n)] = cost_sum / 2;
-
-                        if (cost_sum % 2 == 1)
-                        {
-                            if ((i + j + k + l) % 2 == 0) // total index parity for balance
-                                C[idx4D(i, j, k, l, n)] += 1;
-                            else
-                                C[idx4D(k, l, i, j, n)] += 1;
-                        }
-                    }
-                }
-            }
+            nb_fixed += FixRowPair(C, L, n, m, i, k, gap);
         }
     }
+
+    return nb_fixed;
 }
 
 
-CostMatrix CostMatrix::reduce (int i, int j) const
+template <typename T>
+void CostMatrix<T>::ReduceCosts (const T* C, int n, int m, int i, int j, T* C_new)
 {
-    const int n = this -> size;
-    const int m = n - 1;
-
-    assert(n > 0 && "Cannot reduce problem of size 0.");
-    assert(std::min(i, j) >= 0 && std::max(i, j) < n && "Invalid reduction indices.");
-
-    const vector<int>& C = this -> costs;
-    vector<int> L_copy = this -> leader;
-    
-    vector<int> C_new;
-    vector<int> L_new;
+    const int n2 = n - 1;
+    const int m2 = m - 1;
 
     int x, y, k, l;
-    int x2, y2, k2, l2;
+    int x2, y2, k2;
 
-    // Updating the leader
+    // block (x, y) loses its local row of q_i and column of P_j
+    const int block_size = (n - 1)*(m - 1);
+    const int block_size2 = (n2 - 1)*(m2 - 1);
+
+    x2 = 0;
     for (x = 0; x < n; ++x)
     {
         if (x == i)
             continue;
 
-        for (y = 0; y < n; ++y)
+        const int i_loc = i - (i > x);
+
+        y2 = 0;
+        for (y = 0; y < m; ++y)
         {
-            if (y != j)
+            if (y == j)
+                continue;
+
+            const int j_loc = j - (j > y);
+
+            // copy C_xy into C_x2y2
+            const T* block = C + (x*m + y)*block_size;
+            T* block2 = C_new + (x2*m2 + y2)*block_size2;
+
+            k2 = 0;
+            for (k = 0; k < n - 1; ++k)
             {
-                L_copy[x*n + y] += (C[idx4D(x, y, i, j, n)] + C[idx4D(i, j, x, y, n)]);
+                if (k == i_loc)
+                    continue;
+
+                const T* row = block + k*(m - 1);
+                T* row2 = block2 + k2*(m2 - 1);
+
+                for (l = 0; l < j_loc; ++l)
+                    row2[l] = row[l];
+                for (l = j_loc + 1; l < m - 1; ++l)
+                    row2[l - 1] = row[l];
+
+                ++k2;
             }
+            ++y2;
         }
+        ++x2;
     }
+}
+
+
+/* same reduction as ReduceCosts, the columns assigned to the rows being renumbered and the one of P_j dropped */
+template <typename T>
+void CostMatrix<T>::ReduceAssignment (const int* A, int n, int m, int i, int j, int* A_new)
+{
+    const int n2 = n - 1;
+    const int m2 = m - 1;
 
-    // clearing + reallocating
-    C_new.assign(m*m*m*m, 0);
-    L_new.assign(m*m, 0);
+    int x, y, k;
+    int x2, y2, k2;
 
-    // reducing the matrix
     x2 = 0;
     for (x = 0; x < n; ++x)
     {
         if (x == i)
             continue;
 
+        const int i_loc = i - (i > x);
+
         y2 = 0;
-        for (y = 0; y < n; ++y)
+        for (y = 0; y < m; ++y)
         {
             if (y == j)
                 continue;
 
-            // copy C_xy into C_x2y2
+            const int j_loc = j - (j > y);
+
+            const int* block = A + (x*m + y)*(n - 1);
+            int* block2 = A_new + (x2*m2 + y2)*(n2 - 1);
+
             k2 = 0;
-            for (k = 0; k < n; ++k)
+            for (k = 0; k < n - 1; ++k)
             {
-                if (k == i)
+                if (k == i_loc)
                     continue;
 
-                l2 = 0;
-                for (l = 0; l < n; ++l)
-                {
-                    if (l == j)
-                        continue;
+                const int l = block[k];
+
+                block2[k2] = (l < 0 || l == j_loc) ? -1 : l - (l > j_loc);
 
-                    C_new[idx4D(x2, y2, k2, l2, m)] = C[idx4D(x, y, k, l, n)];
-                    ++l2;
-                }
                 ++k2;
             }
+            ++y2;
+        }
+        ++x2;
+    }
+}
+
 
-            L_new[x2*m + y2] = L_copy[x*n + y];
+template <typename T>
+void CostMatrix<T>::materialize ()
+{
+    const int n = this -> rows;
+    const int m = this -> cols;
+
+    if (costs == nullptr)
+    {
+        costs = Arena::Acquire(TensorSize(n, m) * sizeof(T));
+        leader = Arena::Acquire(n*m * sizeof(T));
+    }
+
+    if (isView())
+    {
+        Buffer* C_new = Arena::Acquire(TensorSize(n, m) * sizeof(T));
+
+        ReduceCosts(static_cast<const T*>(costs->data), n + 1, m + 1, view_i, view_j, static_cast<T*>(C_new->data));
+
+        Arena::Release(costs);
+        costs = C_new;
+
+        if (assignment != nullptr)
+        {
+            Buffer* A_new = Arena::Acquire(AssignmentSize(n, m) * sizeof(int));
+
+            ReduceAssignment(static_cast<const int*>(assignment->data), n + 1, m + 1, view_i, view_j, static_cast<int*>(A_new->data));
+
+            Arena::Release(assignment);
+            assignment = A_new;
+        }
+
+        view_i = -1;
+        view_j = -1;
+    }
+    else if (costs->refs > 1)
+    {
+        // copy-on-write: the tensor is still viewed by children or shared with a clone
+        Buffer* C_new = Arena::Acquire(costs->size);
+
+        std::copy_n(static_cast<const char*>(costs->data), costs->size, static_cast<char*>(C_new->data));
+
+        Arena::Release(costs);
+        costs = C_new;
+    }
+
+    if (leader->refs > 1)
+    {
+        Buffer* L_new = Arena::Acquire(leader->size);
+
+        std::copy_n(static_cast<const char*>(leader->data), leader->size, static_cast<char*>(L_new->data));
+
+        Arena::Release(leader);
+        leader = L_new;
+    }
+
+    if (assignment != nullptr && assignment->refs > 1)
+    {
+        Buffer* A_new = Arena::Acquire(assignment->size);
+
+        std::copy_n(static_cast<const char*>(assignment->data), assignment->size, static_cast<char*>(A_new->data));
+
+        Arena::Release(assignment);
+        assignment = A_new;
+    }
+}
+
+
+template <typename T>
+void CostMatrix<T>::initAssignment ()
+{
+    assert(!isView() && "Error: Cost matrix must be materialized.");
+
+    if (assignment != nullptr)
+        return;
+
+    const int size = AssignmentSize(rows, cols);
+
+    assignment = Arena::Acquire(size * sizeof(int));
+    std::fill_n(static_cast<int*>(assignment->data), size, -1);
+}
+
+
+template <typename T>
+CostMatrix<T> CostMatrix<T>::clone () const
+{
+    CostMatrix CM;
+
+    CM.costs = this -> costs;
+    CM.leader = this -> leader;
+    CM.rows = this -> rows;
+    CM.cols = this -> cols;
+    CM.view_i = this -> view_i;
+    CM.view_j = this -> view_j;
+
+    // buffers are shared until one of the copies gets materialized
+    if (CM.costs != nullptr)
+    {
+        Arena::Share(CM.costs);
+        Arena::Share(CM.leader);
+    }
+
+    CM.assignment = this -> assignment;
+
+    if (CM.assignment != nullptr)
+        Arena::Share(CM.assignment);
+
+    CM.zero_rows = this -> zero_rows;
+
+    return CM;
+}
+
+
+template <typename T>
+CostMatrix<T> CostMatrix<T>::reduce (int i, int j) const
+{
+    const int n = this -> rows;
+    const int m = this -> cols;
+    const int n2 = n - 1;
+    const int m2 = m - 1;
+
+    assert(n > 0 && "Cannot reduce problem of size 0.");
+    assert(i >= 0 && j >= 0 && i < n && j < m && "Invalid reduction indices.");
+
+    // a view of a view is not supported, reduce a dense copy instead
+    if (isView())
+    {
+        CostMatrix CM_dense = clone();
+        CM_dense.materialize();
+
+        return CM_dense.reduce(i, j);
+    }
+
+    const T* C = static_cast<const T*>(this -> costs -> data);
+    const T* L = static_cast<const T*>(this -> leader -> data);
+
+    // the reduced costs are only copied once the child gets materialized
+    CostMatrix CM_new;
+    CM_new.costs = this -> costs;
+    CM_new.leader = Arena::Acquire(n2*m2 * sizeof(T));
+    CM_new.rows = n2;
+    CM_new.cols = m2;
+    CM_new.view_i = i;
+    CM_new.view_j = j;
+
+    Arena::Share(CM_new.costs);
+
+    // so is the assignment of its blocks
+    CM_new.assignment = this -> assignment;
+
+    if (CM_new.assignment != nullptr)
+        Arena::Share(CM_new.assignment);
+
+    // the blocks of the child are sub-blocks of its parent's ones, row i leaving
+    CM_new.zero_rows = (i < 64) ? (this -> zero_rows & ((uint64_t(1) << i) - 1)) | ((this -> zero_rows >> i >> 1) << i) : this -> zero_rows;
+
+    T* L_new = static_cast<T*>(CM_new.leader -> data);
+
+    int x, y;
+    int x2, y2;
+
+    // updating the leader
+    x2 = 0;
+    for (x = 0; x < n; ++x)
+    {
+        if (x == i)
+            continue;
+
+        y2 = 0;
+        for (y = 0; y < m; ++y)
+        {
+            if (y == j)
+                continue;
+
+            L_new[x2*m2 + y2] = CheckedAdd(CheckedAdd(L[x*m + y], C[idx4D(x, y, i, j, n, m)]), C[idx4D(i, j, x, y, n, m)]);
             ++y2;
         }
         ++x2;
     }
 
-    return CostMatrix{C_new, L_new, m};
+    return CM_new;
 }
+
+
+template <typename T>
+void CostMatrix<T>::write (FILE* file) const
+{
+    CostMatrix CM_dense = clone();
+    CM_dense.materialize();
+
+    const int dims[3] = {rows, cols, hasAssignment()};
+
+    WriteBytes(file, dims, sizeof(dims));
+    WriteBytes(file, CM_dense.get_costs(), TensorSize(rows, cols) * sizeof(T));
+    WriteBytes(file, CM_dense.get_leader(), rows*cols * sizeof(T));
+
+    if (hasAssignment())
+        WriteBytes(file, CM_dense.get_assignment(), AssignmentSize(rows, cols) * sizeof(int));
+}
+
+
+template <typename T>
+CostMatrix<T> CostMatrix<T>::Read (FILE* file)
+{
+    int dims[3];
+
+    ReadBytes(file, dims, sizeof(dims));
+
+    CostMatrix CM(dims[0], dims[1]);
+
+    ReadBytes(file, CM.get_costs(), TensorSize(dims[0], dims[1]) * sizeof(T));
+    ReadBytes(file, CM.get_leader(), dims[0]*dims[1] * sizeof(T));
+
+    if (dims[2])
+    {
+        CM.initAssignment();
+        ReadBytes(file, CM.get_assignment(), AssignmentSize(dims[0], dims[1]) * sizeof(int));
+    }
+
+    return CM;
+}
+
+
+/*
+ * Width in bits of the narrowest cost type that safely holds the instance. Every entry of the
+ * cost matrices stays below Umax = max(D) * sum(F) along the bounding procedure, sums of two
+ * entries and Hungarian potentials stay within a few Umax: a 4x headroom is kept.
+ */
+int CostTypeBits (const vector<vector<int>>& D, const vector<vector<int>>& F, int n)
+{
+    int64_t max_D = 0;
+    for (const vector<int>& row : D)
+        for (int d : row)
+            max_D = std::max(max_D, (int64_t)d);
+
+    int64_t sum_F = 0;
+    for (int i = 0; i < n; ++i)
+        for (int k = 0; k < n; ++k)
+            sum_F += F[i][k];
+
+    const int64_t u_max = 4 * max_D * sum_F;
+
+    if (u_max <= std::numeric_limits<int16_t>::max())
+        return 16;
+    if (u_max <= std::numeric_limits<int32_t>::max())
+        return 32;
+
+    return 64;
+}
+
+
+template class CostMatrix<int16_t>;
+template class CostMatrix<int32_t>;
+template class CostMatrix<int64_t>;
@@ -1,17 +1,271 @@
 #include "../include/node.hpp"
-#include "../include/hungarian.hpp"
+#include "../include/lap.hpp"
+#include "../include/kernels.hpp"
 
 
-Node Node::Root (const vector<vector<int>>& D, const vector<vector<int>>& F, int n, int m)
+BoundingOptions BoundingOptions::Parse (int argc, char** argv, const vector<vector<int>>& D)
+{
+    BoundingOptions options;
+
+    // reduced-cost fixing
+    options.fixing = static_cast<bool>(std::stoi(OptionalArgument(argc, argv, "fixing", "0")));
+
+    // bound cascade
+    options.cascade = ParseCascade(OptionalArgument(argc, argv, "cascade", "none"));
+
+    // bounding schedule
+    options.schedule = ParseSchedule(OptionalArgument(argc, argv, "it-schedule", "none"));
+    options.min_gain = std::stod(OptionalArgument(argc, argv, "min-gain", "0"));
+    options.gap_stop = static_cast<bool>(std::stoi(OptionalArgument(argc, argv, "gap-stop", "0")));
+
+    // order of the children
+    options.child_order = ParseChildOrder(OptionalArgument(argc, argv, "child-order", "index"));
+
+    if (options.child_order)
+        options.distances = D;
+
+    // branching variable selection
+    options.branching = ParseBranching(OptionalArgument(argc, argv, "branching", "static"));
+
+    return options;
+}
+
+
+vector<string> BoundingOptions::OptionNames ()
+{
+    return {"fixing", "cascade", "it-schedule", "min-gain", "gap-stop", "child-order", "branching"};
+}
+
+
+vector<BoundLevel> BoundingOptions::ParseCascade (const string& list)
+{
+    vector<BoundLevel> levels;
+
+    if (list == "none")
+        return levels;
+
+    std::stringstream ss(list);
+    string name;
+
+    while (std::getline(ss, name, ','))
+    {
+        if (name == "leader")
+            levels.push_back(BoundLevel::Leader);
+        else if (name == "glb")
+            levels.push_back(BoundLevel::GilmoreLawler);
+        else
+        {
+            cerr << "Error: unknown bound level " << name << ", expected a comma separated list of leader and glb, or none" << endl;
+            exit(1);
+        }
+    }
+
+    return levels;
+}
+
+
+string BoundingOptions::Name (BoundLevel level)
+{
+    switch (level)
+    {
+        case BoundLevel::Leader:
+            return "leader";
+        case BoundLevel::GilmoreLawler:
+            return "glb";
+        default:
+            return "iterative";
+    }
+}
+
+
+vector<int> BoundingOptions::ParseSchedule (const string& list)
+{
+    vector<int> budgets;
+
+    if (list == "none")
+        return budgets;
+
+    std::stringstream ss(list);
+    string budget;
+
+    while (std::getline(ss, budget, ','))
+    {
+        if (budget.empty() || budget.find_first_not_of("0123456789") != string::npos)
+        {
+            cerr << "Error: invalid iteration budget " << budget << ", expected a comma separated list of non-negative integers, or none" << endl;
+            exit(1);
+        }
+
+        budgets.push_back(std::stoi(budget));
+    }
+
+    return budgets;
+}
+
+
+bool BoundingOptions::ParseChildOrder (const string& name)
+{
+    if (name == "index")
+        return false;
+    if (name == "bound")
+        return true;
+
+    cerr << "Error: unknown child order " << name << ", expected index or bound" << endl;
+    exit(1);
+}
+
+
+Branching BoundingOptions::ParseBranching (const string& name)
+{
+    if (name == "static")
+        return Branching::Static;
+    if (name == "regret")
+        return Branching::Regret;
+    if (name == "fewest")
+        return Branching::Fewest;
+
+    cerr << "Error: unknown branching " << name << ", expected static, regret or fewest" << endl;
+    exit(1);
+}
+
+
+string BoundingOptions::Name (Branching rule)
+{
+    switch (rule)
+    {
+        case Branching::Regret:
+            return "regret";
+        case Branching::Fewest:
+            return "fewest";
+        default:
+            return "static";
+    }
+}
+
+
+bool BoundingOptions::StopIterating (int64_t incre, int lb, int min_cost, int it, int budget) const
+{
+    const int64_t gap = (int64_t)min_cost - lb;
+
+    // marginal gain, against the gap left before the iteration
+    if (incre < min_gain * (gap + incre))
+        return true;
+
+    // even the same gain at each remaining iteration would leave the node alive
+    if (gap_stop && (budget - it) * incre <= gap)
+        return true;
+
+    return false;
+}
+
+
+void BoundingOptions::ChildOrder (const vector<int>& lbs, const vector<bool>& av, const int min_cost, vector<int>& order) const
+{
+    const int m = av.size();
+
+    order.clear();
+
+    // by index, P_0 explored first
+    for (int j = m - 1; j >= 0; --j)
+        if (av[j] && lbs[j] <= min_cost)
+            order.push_back(j);
+
+    if (!child_order)
+        return;
+
+    // sum of the distances to the physical qubits already taken, scratch of the calling thread
+    static thread_local vector<int> locality;
+    locality.assign(m, 0);
+
+    for (int j : order)
+        for (int p = 0; p < m; ++p)
+            if (!av[p])
+                locality[j] += distances[j][p];
+
+    // worst first, the index order breaking the remaining ties, without the buffer of a stable sort
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        if (lbs[a] != lbs[b])
+            return lbs[a] > lbs[b];
+
+        if (locality[a] != locality[b])
+            return locality[a] > locality[b];
+
+        return a > b;
+    });
+}
+
+
+double Bounding::nb_fixed = 0;
+double Bounding::nb_tried[3] = {0, 0, 0};
+double Bounding::nb_pruned[3] = {0, 0, 0};
+vector<double> Bounding::nb_bounded;
+vector<double> Bounding::nb_iterations;
+double Bounding::nb_reordered = 0;
+
+
+void Bounding::CountFixed (int count)
+{
+    #pragma omp atomic
+    nb_fixed += count;
+}
+
+
+void Bounding::CountLevel (BoundLevel level, bool pruned)
+{
+    #pragma omp atomic
+    nb_tried[int(level)] += 1;
+
+    if (pruned)
+    {
+        #pragma omp atomic
+        nb_pruned[int(level)] += 1;
+    }
+}
+
+
+void Bounding::CountIterations (int depth, int it)
+{
+    if (depth >= (int)nb_bounded.size())
+    {
+        nb_bounded.resize(depth + 1, 0);
+        nb_iterations.resize(depth + 1, 0);
+    }
+
+    nb_bounded[depth] += 1;
+    nb_iterations[depth] += it;
+}
+
+
+template <typename T>
+Node<T> Node<T>::Root (const vector<vector<int>>& D, const vector<vector<int>>& F, int n, int m, bool rectangular, bool warm_start)
 {
     Solution sol;
     vector<int> map(n, -1);
     sol.mapping = map;
     sol.cost = -1;
     vector<bool> available(m, true);
-    CostMatrix CM = CostMatrix::Assemble(D, F, m);
+    // the rectangular tensor only holds the n logical qubits, the square one pads them to m
+    CostMatrix<T> CM = CostMatrix<T>::Assemble(D, F, rectangular ? n : m, m);
+
+    // block assignments kept along the bounding iterations and handed down to the children
+    if (warm_start)
+        CM.initAssignment();
 
-    return Node{sol, 0, 0, CM, available};
+    return Node{sol, 0, 0, std::move(CM), available};
+}
+
+
+template <typename T>
+void Node<T>::expand ()
+{
+    if (!isLazy())
+        return;
+
+    costMatrix = costMatrix.reduce(branch_k, branch_l);
+
+    branch_k = -1;
+    branch_l = -1;
 }
 
 
@@ -42,22 +296,249 @@ int localPhysicalQubitIndex (const vector<bool>& av, int j)
 }
 
 
-int Node::bound (int it_max, int min_cost, int& it, bool early_stop, double& rt)
+// unassigned logical qubit selected by the dynamic branching rule from the leader of a node bounded at lb,
+// the first one in priority order on ties
+template <typename T>
+int BranchingQubit (Branching rule, const CostMatrix<T>& CM, const vector<int>& mapping, const vector<int>& priority, int lb, int min_cost)
+{
+    const T* L = CM.get_leader();
+    const int m = CM.get_cols();
+    const bool fewest = (rule == Branching::Fewest);
+
+    int first_i = -1, best_i = -1;
+    int64_t best_score = std::numeric_limits<int64_t>::min();
+
+    // the assigned logical qubits need not be a prefix of the priority order, whose first n entries are the real ones
+    for (int d = 0; d < (int)mapping.size(); ++d)
+    {
+        const int i = priority[d];
+
+        if (mapping[i] != -1)
+            continue;
+
+        if (first_i == -1)
+            first_i = i;
+
+        const T* row = L + localLogicalQubitIndex(mapping, i)*m;
+
+        int64_t score;
+
+        if (fewest)
+        {
+            // children surviving the pruning of decompose, the fewer the better
+            score = 0;
+            for (int l = 0; l < m; ++l)
+                score -= (lb + (int64_t)row[l] <= min_cost);
+        }
+        else
+        {
+            // two smallest reduced costs of the row, a single column having no alternative
+            int64_t min1 = row[0], min2 = INF;
+
+            for (int l = 1; l < m; ++l)
+            {
+                if (row[l] < min1)
+                {
+                    min2 = min1;
+                    min1 = row[l];
+                }
+                else if (row[l] < min2)
+                    min2 = row[l];
+            }
+
+            score = min2 - min1;
+        }
+
+        if (score > best_score)
+        {
+            best_score = score;
+            best_i = i;
+        }
+    }
+
+    if (best_i != first_i)
+        Bounding::CountReordered();
+
+    return best_i;
+}
+
+
+/*
+ * LAPs of nb_blocks consecutive blocks with the blocks backend, the Hungarian one solving them
+ * in lockstep and warm starting from A. All-zero blocks are skipped: any backend would leave
+ * them as they are with a zero cost. The blocks of the zero_rows of the tensor, block first
+ * being (first / cols, first % cols), are skipped without being scanned; the others are scanned
+ * at each batch, since the leader distribution and the halving refill or empty them.
+ */
+template <typename T>
+static void SolveBlocks (BatchHungarian<T>& batch, T* C, int block_size, int nb_blocks, int n, int m, T* costs, int* A,
+                         int first = 0, int cols = 1, uint64_t zero_rows = 0)
+{
+    const LAPBackend backend = LAP::get_blocks();
+
+    int blocks[BatchHungarian<T>::LANES];
+    int nb_nonzero = 0;
+
+    for (int b = 0; b < nb_blocks; ++b)
+    {
+        const int i = (first + b) / cols;
+
+        if ((i < 64 && (zero_rows >> i) & 1) || IsZeroBlock(C + b*block_size, n*m))
+            costs[b] = 0;
+        else
+            blocks[nb_nonzero++] = b;
+    }
+
+    LAP::CountBlocks(nb_nonzero, nb_blocks - nb_nonzero);
+
+    if (nb_nonzero == 0)
+        return;
+
+    if (backend == LAPBackend::Hungarian)
+    {
+        batch.solve(C, block_size, blocks, nb_nonzero, n, m, costs, A);
+        return;
+    }
+
+    for (int k = 0; k < nb_nonzero; ++k)
+        costs[blocks[k]] = LAP::Solve(backend, C + blocks[k]*block_size, n, m);
+}
+
+
+// 2*m entries of scratch for the row pair sweeps of the calling thread, kept across the nodes
+template <typename T>
+static T* RowPairScratch (int m)
+{
+    static thread_local vector<T> tmp;
+    tmp.resize(2*m);
+
+    return tmp.data();
+}
+
+
+/*
+ * Leader L of the Gilmore-Lawler bound of a materialized cost matrix: the block LAPs are solved on
+ * per-batch copies and their costs added to L, once and without spreading the leader.
+ */
+template <typename T>
+static void GilmoreLawlerLeader (const CostMatrix<T>& CM, T* L, int nb_threads)
+{
+    const int n = CM.get_rows();
+    const int m = CM.get_cols();
+    const T* C = CM.get_costs();
+    const int block_size = CM.get_blockSize();
+    const int lanes = BatchHungarian<T>::LANES;
+    const uint64_t zero_rows = CM.get_zeroRows();
+
+    #pragma omp parallel num_threads(nb_threads)
+    {
+        BatchHungarian<T>& batch = BatchHungarian<T>::Local();
+        T costs[BatchHungarian<T>::LANES];
+
+        // block copies of the thread, grown to the largest tensor seen
+        static thread_local vector<T> blocks;
+        blocks.resize(lanes * block_size);
+
+        #pragma omp for schedule(dynamic)
+        for (int idx_batch = 0; idx_batch < n*m; idx_batch += lanes)
+        {
+            const int nb_blocks = std::min(lanes, n*m - idx_batch);
+
+            std::copy_n(C + idx_batch*block_size, nb_blocks*block_size, blocks.data());
+
+            SolveBlocks(batch, blocks.data(), block_size, nb_blocks, n - 1, m - 1, costs, nullptr, idx_batch, m, zero_rows);
+
+            for (int b = 0; b < nb_blocks; ++b)
+                L[idx_batch + b] = CheckedAdd(L[idx_batch + b], costs[b]);
+        }
+    }
+}
+
+
+template <typename T>
+bool Node<T>::prefilter (const BoundingOptions& options, int min_cost, bool parallel)
+{
+    CostMatrix<T>& CM = this->costMatrix;
+
+    const int n = CM.get_rows();
+    const int m = CM.get_cols();
+
+    // leader copy of the calling thread
+    static thread_local vector<T> L;
+
+    for (BoundLevel level : options.cascade)
+    {
+        // both levels leave the node's tensor untouched, their LAPs being solved on copies
+        L.assign(CM.get_leader(), CM.get_leader() + n*m);
+
+        if (level == BoundLevel::GilmoreLawler && n > 1)
+        {
+            // the block costs are needed, views get built
+            CM.materialize();
+
+            GilmoreLawlerLeader(CM, L.data(), parallel ? std::min(n*m / BatchHungarian<T>::LANES + 1, omp_get_max_threads()) : 1);
+        }
+
+        const int lb_level = CheckedAdd(this->lower_bound, LAP::SolveLeader(L.data(), n, m, (int64_t)min_cost - this->lower_bound));
+        const bool pruned = (lb_level > min_cost);
+
+        Bounding::CountLevel(level, pruned);
+
+        // the lower bound of a surviving node stays the constant of its reformulated costs
+        if (pruned)
+        {
+            this->lower_bound = lb_level;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+template <typename T>
+int Node<T>::bound (const BoundingOptions& options, int it_max, int min_cost, int& it, bool early_stop, double& rt)
 {
     auto t0 = std::chrono::high_resolution_clock::now();
 
     int& lb = this->lower_bound;
-    CostMatrix& CM = this->costMatrix;
+    CostMatrix<T>& CM = this->costMatrix;
+
+    // iteration budget of the node's depth
+    it_max = options.Budget(it_max, this->size);
+
+    // lazy children only get their cost matrix if they are still worth bounding
+    if (it_max > 0 && lb <= min_cost)
+        expand();
+
+    // cheaper bounds first, the iterative one only running on the nodes they could not prune
+    if (it_max > 0 && lb <= min_cost && prefilter(options, min_cost, false))
+    {
+        it = 0;
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> delta = t1 - t0;
+        rt += delta.count();
+
+        return lb;
+    }
 
-    const int m = CM.get_size();
+    const int n = CM.get_rows();
+    const int m = CM.get_cols();
 
-    assert(m > 0 && "Error: Cannot bound problem of size 0.");
+    assert(n > 0 && "Error: Cannot bound problem of size 0.");
 
-    vector<int>& C = CM.get_costs();
-    vector<int>& L = CM.get_leader();
+    const int block_size = CM.get_blockSize();
 
-    int i, j;
-    int cost, incre, idx_submat;
+    T incre;
+
+    BatchHungarian<T>& batch = BatchHungarian<T>::Local();
+
+    const int lanes = BatchHungarian<T>::LANES;
+    T costs[lanes];
+
+    // idle rows of an unbounded tensor, only known before its first leader distribution
+    const uint64_t zero_rows = CM.get_zeroRows();
 
     it = 0;
 
@@ -65,30 +546,52 @@ int Node::bound (int it_max, int min_cost, int& it, bool early_stop, double& rt)
     {
         ++ it;
 
+        // children are views over their parent's tensor until they actually get bounded
+        CM.materialize();
+
+        T* C = CM.get_costs();
+        T* L = CM.get_leader();
+        int* A = CM.get_assignment();
+
         CM.distributeLeader();
 
         CM.halveComplementary();
 
-        // apply Hungarian algorithm to each sub-matrix
-        for (i = 0; i < m; ++i)
+        // apply Hungarian algorithm to each sub-matrix, by batches of consecutive blocks
+        for (int idx_batch = 0; idx_batch < n*m; idx_batch += lanes)
         {
-            for (j = 0; j < m; ++j)
-            {
-                idx_submat = i*m + j;
+            const int nb_blocks = std::min(lanes, n*m - idx_batch);
 
-                cost = Hungarian(C.data(), i, j, m);
+            SolveBlocks(batch, C + idx_batch*block_size, block_size, nb_blocks, n - 1, m - 1, costs, A ? A + idx_batch*(n - 1) : nullptr,
+                        idx_batch, m, (it == 1) ? zero_rows : 0);
 
-                L[idx_submat] += cost;
-            }
+            for (int b = 0; b < nb_blocks; ++b)
+                L[idx_batch + b] = CheckedAdd(L[idx_batch + b], costs[b]);
         }
 
+        CM.clearZeroRows();
+
         // apply Hungarian algorithm to the leader matrix
-        incre = Hungarian(L.data(), 0, 0, m);
+        // stopped as soon as it proves the node pruned, the loop then ending
+        incre = LAP::SolveLeader(L, n, m, (int64_t)min_cost - lb);
 
         if (early_stop && incre == 0)
             break;
 
-        lb += incre;
+        lb = CheckedAdd(lb, incre);
+
+        // the next iteration and the children only see the assignments still within min_cost
+        if (options.fixing && lb <= min_cost)
+            Bounding::CountFixed(CM.fixVariables(lb, min_cost));
+
+        if (early_stop && options.StopIterating(incre, lb, min_cost, it, it_max))
+            break;
+    }
+
+    if (it > 0)
+    {
+        Bounding::CountLevel(BoundLevel::Iterative, lb > min_cost);
+        Bounding::CountIterations(this->size, it);
     }
 
     auto t1 = std::chrono::high_resolution_clock::now();
@@ -99,55 +602,157 @@ int Node::bound (int it_max, int min_cost, int& it, bool early_stop, double& rt)
 }
 
 
-int Node::bound_OMP (int it_max, int min_cost, int& it, bool early_stop, double& rt)
+/*
+ * A single parallel region lives across all the bounding iterations. Each iteration runs three
+ * phases separated by the implicit barriers of the worksharing constructs: the leader is spread
+ * and the complementary costs halved by pair of logical rows in one sweep, then each block is
+ * solved and its cost becomes the new leader entry, then one thread solves the leader.
+ */
+template <typename T>
+int Node<T>::bound_OMP (const BoundingOptions& options, int it_max, int min_cost, int& it, bool early_stop, double& rt)
 {
     auto t0 = std::chrono::high_resolution_clock::now();
 
     int& lb = this->lower_bound;
-    CostMatrix& CM = this->costMatrix;
+    CostMatrix<T>& CM = this->costMatrix;
+
+    // iteration budget of the node's depth
+    it_max = options.Budget(it_max, this->size);
+
+    // lazy children only get their cost matrix if they are still worth bounding
+    if (it_max > 0 && lb <= min_cost)
+        expand();
+
+    // cheaper bounds first, the iterative one only running on the nodes they could not prune
+    if (it_max > 0 && lb <= min_cost && prefilter(options, min_cost, true))
+    {
+        it = 0;
 
-    const int m = CM.get_size();
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> delta = t1 - t0;
+        rt += delta.count();
 
-    assert(m > 0 && "Error: Cannot bound problem of size 0.");
+        return lb;
+    }
+
+    const int n = CM.get_rows();
+    const int m = CM.get_cols();
 
-    vector<int>& C = CM.get_costs();
-    vector<int>& L = CM.get_leader();
+    assert(n > 0 && "Error: Cannot bound problem of size 0.");
 
-    int i, j;
-    int cost, incre, idx_submat;
-    int m2 = m*m;
+    const int block_size = CM.get_blockSize();
+    const int nb_threads = std::min(n*m, omp_get_max_threads());
 
-    const int nb_threads = std::min(m2, omp_get_max_threads());
+    // blocks solved together, fewer than a full batch when the threads would run out of batches
+    const int lanes = std::max(1, std::min(BatchHungarian<T>::LANES, n*m / nb_threads));
 
     it = 0;
 
-    while (it < it_max && lb <= min_cost)
+    bool done = !(it < it_max && lb <= min_cost);
+
+    // reduced-cost fixing decided by the thread solving the leader
+    bool fix = false;
+    int64_t gap = 0;
+
+    if (!done)
     {
-        ++ it;
+        // children are views over their parent's tensor until they actually get bounded
+        CM.materialize();
 
-        CM.distributeLeader_OMP();
+        T* C = CM.get_costs();
+        T* L = CM.get_leader();
+        int* A = CM.get_assignment();
 
-        CM.halveComplementary_OMP();
+        // idle rows of an unbounded tensor, only known before its first leader distribution
+        const uint64_t zero_rows = CM.get_zeroRows();
+        CM.clearZeroRows();
 
-        #pragma omp parallel for collapse(2) default(none) private(i, j, cost, idx_submat) shared(C, L, m, m2) num_threads(nb_threads)
-        for (i = 0; i < m; ++i)
+        #pragma omp parallel default(none) shared(options, C, L, A, n, m, block_size, lanes, it, it_max, lb, min_cost, early_stop, done, fix, gap, zero_rows) num_threads(nb_threads)
         {
-            for (j = 0; j < m; ++j)
+            // thread scratch of the row pair sweep, and LAP solvers whose buffers outlive the region
+            T* tmp = RowPairScratch<T>(m);
+            BatchHungarian<T>& batch = BatchHungarian<T>::Local();
+            T costs[BatchHungarian<T>::LANES];
+
+            // done is only written by the single thread, the barrier closing it publishes the decision
+            while (!done)
             {
-                idx_submat = i*m + j;
+                // leader distribution & complementary halving
+                if (n > 1)
+                {
+                    #pragma omp for collapse(2) schedule(dynamic)
+                    for (int i = 0; i < n; ++i)
+                    {
+                        for (int k = 0; k < n; ++k)
+                        {
+                            if (k > i)
+                                DistributeHalveRowPair(C, L, n, m, i, k, tmp);
+                        }
+                    }
+                }
 
-                cost = Hungarian(C.data(), i, j, m);
+                // apply Hungarian algorithm to each sub-matrix, the leader having been spread unless n = 1
+                #pragma omp for schedule(dynamic)
+                for (int idx_batch = 0; idx_batch < n*m; idx_batch += lanes)
+                {
+                    const int nb_blocks = std::min(lanes, n*m - idx_batch);
 
-                L[idx_submat] += cost;
-            }
-        }
+                    SolveBlocks(batch, C + idx_batch*block_size, block_size, nb_blocks, n - 1, m - 1, costs, A ? A + idx_batch*(n - 1) : nullptr,
+                                idx_batch, m, (it == 0) ? zero_rows : 0);
 
-        incre = Hungarian(L.data(), 0, 0, m);
+                    for (int b = 0; b < nb_blocks; ++b)
+                        L[idx_batch + b] = CheckedAdd((n > 1) ? T(0) : L[idx_batch + b], costs[b]);
+                }
 
-        if (early_stop && incre == 0)
-            break;
+                // apply Hungarian algorithm to the leader matrix
+                #pragma omp single
+                {
+                    ++ it;
+
+                    T incre = LAP::SolveLeader(L, n, m, (int64_t)min_cost - lb);
+
+                    if (early_stop && incre == 0)
+                    {
+                        done = true;
+                    }
+                    else
+                    {
+                        lb = CheckedAdd(lb, incre);
+                        done = !(it < it_max && lb <= min_cost) || (early_stop && options.StopIterating(incre, lb, min_cost, it, it_max));
+                    }
+
+                    fix = options.fixing && lb <= min_cost && !(early_stop && incre == 0);
+                    gap = (int64_t)min_cost - lb;
+
+                    if (fix)
+                        Bounding::CountFixed(FixLeader(L, n, m, gap));
+                }
+
+                // reduced-cost fixing by pair of logical rows
+                if (fix)
+                {
+                    int nb_fixed = 0;
+
+                    #pragma omp for collapse(2) schedule(dynamic)
+                    for (int i = 0; i < n; ++i)
+                    {
+                        for (int k = 0; k < n; ++k)
+                        {
+                            if (k > i)
+                                nb_fixed += FixRowPair(C, L, n, m, i, k, gap);
+                        }
+                    }
 
-        lb += incre;
+                    Bounding::CountFixed(nb_fixed);
+                }
+            }
+        }
+    }
+
+    if (it > 0)
+    {
+        Bounding::CountLevel(BoundLevel::Iterative, lb > min_cost);
+        Bounding::CountIterations(this->size, it);
     }
 
     auto t1 = std::chrono::high_resolution_clock::now();
@@ -158,54 +763,416 @@ int Node::bound_OMP (int it_max, int min_cost, int& it, bool early_stop, double&
 }
 
 
-vector<Node> Node::decompose (const vector<int>& priority, int n, int m, int min_cost)
+template <typename T>
+void Node<T>::decompose (const BoundingOptions& options, const vector<int>& priority, int n, int m, int min_cost, vector<Node>& children)
 {
-    vector<Node> children;
+    // a node decomposed without having been bounded is still lazy
+    expand();
+
+    children.clear();
 
     Solution& sol = this->solution;
     const int sz = this->size;
     const int lb = this->lower_bound;
-    const CostMatrix& CM = this->costMatrix;
+    const CostMatrix<T>& CM = this->costMatrix;
     vector<bool>& av = this->available;
 
     // next logical qubit q_i to assign
-    int i = priority[sz];
+    int i = (options.branching == Branching::Static) ? priority[sz] : BranchingQubit(options.branching, CM, sol.mapping, priority, lb, min_cost);
 
     // local index of q_i in the cost matrix
     int k = localLogicalQubitIndex(sol.mapping, i);
 
-    // iterate over available physical qubits
-    for (int j = m - 1; j >= 0; --j)
+    // increment lower bound of each available physical qubit, and push order of the children,
+    // scratch of the calling thread
+    static thread_local vector<int> lbs, order;
+    lbs.assign(m, INF);
+
+    for (int j = 0, l = 0; j < m; ++j)
     {
         if (!av[j]) continue; // skip if not available
 
+        // l is the local index of P_j in the cost matrix
+        lbs[j] = CheckedAdd(lb, CM.get_leader()[k * CM.get_cols() + l++]);
+    }
+
+    // iterate over the surviving physical qubits
+    options.ChildOrder(lbs, av, min_cost, order);
+
+    for (int j : order)
+    {
         // local index of P_j in the cost matrix
         int l = localPhysicalQubitIndex(av, j);
-        
-        // increment lower bound
-        int incre = CM.get_leader()[k * (m - sz) + l];
-        int lb_new = lb + incre;
-
-        // prune
-        if (lb_new > min_cost)
-        {
-            continue;
-        }
+        int lb_new = lbs[j];
 
         // assign q_i to P_j
         sol.mapping[i] = j;
         av[j] = false;
 
-        // reduce cost matrix according to the new sub-problem
-        CostMatrix CM_new = CM.reduce(k, l);
-
-        // insert in children vector
-        children.push_back(Node{sol, sz+1, lb_new, CM_new, av});
+        // insert in children vector: the cost matrix is only reduced according to the new sub-problem
+        // if the child survives until it gets bounded, leaves do not need any
+        if (sz + 1 == n)
+            children.push_back(Node{sol, sz+1, lb_new, CostMatrix<T>(), av});
+        else
+            children.push_back(Node{sol, sz+1, lb_new, CM.clone(), av, k, l});
 
         // restore data
         sol.mapping[i] = -1;
         av[j] = true;
     }
 
-    return children;
+    // the only allocations of a decomposition, its children owning their mapping and availability
+    Arena::CountNodeStates(children.size());
 }
+
+
+// bookkeeping of BoundSiblings, kept by the calling thread from one decomposition to the next
+template <typename T>
+struct SiblingScratch
+{
+    vector<Node<T>*> group, active;
+    vector<int> lb_level, it_active;
+    vector<T*> C, L;
+    vector<int*> A;
+    vector<char> done, fix;
+    vector<uint64_t> zero_rows;
+};
+
+
+template <typename T>
+void Node<T>::BoundSiblings (const BoundingOptions& options, vector<Node>& siblings, int it_max, int min_cost, bool early_stop, bool parallel,
+                              vector<int>& its, double& rt)
+{
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    const int nb_siblings = siblings.size();
+
+    its.assign(nb_siblings, -1);
+
+    if (nb_siblings == 0)
+        return;
+
+    // iteration budget of the siblings' depth
+    it_max = options.Budget(it_max, siblings[0].size);
+
+    static thread_local SiblingScratch<T> scratch;
+
+    // siblings left to bound, leaves aside
+    vector<Node*>& group = scratch.group;
+    group.clear();
+
+    for (int s = 0; s < nb_siblings; ++s)
+    {
+        Node& node = siblings[s];
+
+        node.expand();
+
+        if (node.costMatrix.isEmpty())
+            continue;
+
+        node.bounded = true;
+        its[s] = 0;
+
+        if (it_max > 0 && node.lower_bound <= min_cost)
+            group.push_back(&node);
+    }
+
+    if (group.empty())
+        return;
+
+    // all the siblings share the layout of their parent
+    const int n = group[0]->costMatrix.get_rows();
+    const int m = group[0]->costMatrix.get_cols();
+    const int block_size = group[0]->costMatrix.get_blockSize();
+
+    const int nb_threads = parallel ? std::min((int)group.size()*n*m, omp_get_max_threads()) : 1;
+
+    // the levels of the cascade, as prefilter runs them, one sibling per thread
+    vector<Node*>& active = scratch.active;
+    vector<int>& lb_level = scratch.lb_level;
+
+    active.assign(group.begin(), group.end());
+
+    for (BoundLevel level : options.cascade)
+    {
+        // the block costs are needed, views get built outside of the parallel region since the arena is not thread safe
+        if (level == BoundLevel::GilmoreLawler && n > 1)
+            for (Node* node : active)
+                node->costMatrix.materialize();
+
+        lb_level.assign(active.size(), 0);
+
+        #pragma omp parallel for schedule(dynamic) num_threads(nb_threads)
+        for (int s = 0; s < (int)active.size(); ++s)
+        {
+            const CostMatrix<T>& CM = active[s]->costMatrix;
+
+            // leader copy of the thread
+            static thread_local vector<T> L;
+            L.assign(CM.get_leader(), CM.get_leader() + n*m);
+
+            if (level == BoundLevel::GilmoreLawler && n > 1)
+                GilmoreLawlerLeader(CM, L.data(), 1);
+
+            lb_level[s] = CheckedAdd(active[s]->lower_bound, LAP::SolveLeader(L.data(), n, m, (int64_t)min_cost - active[s]->lower_bound));
+        }
+
+        int x = 0;
+
+        for (int s = 0; s < (int)active.size(); ++s)
+        {
+            Bounding::CountLevel(level, lb_level[s] > min_cost);
+
+            if (lb_level[s] > min_cost)
+                active[s]->lower_bound = lb_level[s];
+            else
+                active[x++] = active[s];
+        }
+
+        active.resize(x);
+    }
+
+    const int nb_active = active.size();
+
+    // tensors only get built for the survivors, outside of the parallel region since the arena is not thread safe
+    vector<T*>& C = scratch.C;
+    vector<T*>& L = scratch.L;
+    vector<int*>& A = scratch.A;
+    vector<int>& it_active = scratch.it_active;
+    vector<char>& done = scratch.done;
+    vector<char>& fix = scratch.fix;
+    vector<uint64_t>& zero_rows = scratch.zero_rows;
+
+    C.resize(nb_active);
+    L.resize(nb_active);
+    A.resize(nb_active);
+    it_active.assign(nb_active, 0);
+    done.assign(nb_active, 0);
+    fix.assign(nb_active, 0);
+    zero_rows.resize(nb_active);
+
+    for (int s = 0; s < nb_active; ++s)
+    {
+        CostMatrix<T>& CM = active[s]->costMatrix;
+
+        CM.materialize();
+
+        C[s] = CM.get_costs();
+        L[s] = CM.get_leader();
+        A[s] = CM.get_assignment();
+
+        zero_rows[s] = CM.get_zeroRows();
+        CM.clearZeroRows();
+    }
+
+    // blocks solved together, fewer than a full batch when the threads would run out of batches
+    const int lanes = std::max(1, std::min(BatchHungarian<T>::LANES, nb_active*n*m / nb_threads));
+    const int nb_batches = (n*m + lanes - 1) / lanes;
+
+    bool all_done = (nb_active == 0);
+
+    if (!all_done)
+    {
+        #pragma omp parallel default(none) shared(options, active, C, L, A, it_active, done, fix, zero_rows, all_done, nb_active, n, m, block_size, lanes, nb_batches, it_max, min_cost, early_stop) num_threads(nb_threads)
+        {
+            T* tmp = RowPairScratch<T>(m);
+            BatchHungarian<T>& batch = BatchHungarian<T>::Local();
+            T costs[BatchHungarian<T>::LANES];
+
+            while (!all_done)
+            {
+                // leader distribution & complementary halving of all the siblings still bounded
+                if (n > 1)
+                {
+                    #pragma omp for collapse(3) schedule(dynamic)
+                    for (int s = 0; s < nb_active; ++s)
+                    {
+                        for (int i = 0; i < n; ++i)
+                        {
+                            for (int k = 0; k < n; ++k)
+                            {
+                                if (k > i && !done[s])
+                                    DistributeHalveRowPair(C[s], L[s], n, m, i, k, tmp);
+                            }
+                        }
+                    }
+                }
+
+                // their block LAPs, as one pool of batches
+                #pragma omp for collapse(2) schedule(dynamic)
+                for (int s = 0; s < nb_active; ++s)
+                {
+                    for (int x = 0; x < nb_batches; ++x)
+                    {
+                        if (done[s])
+                            continue;
+
+                        const int idx_batch = x*lanes;
+                        const int nb_blocks = std::min(lanes, n*m - idx_batch);
+
+                        SolveBlocks(batch, C[s] + idx_batch*block_size, block_size, nb_blocks, n - 1, m - 1, costs,
+                                    A[s] ? A[s] + idx_batch*(n - 1) : nullptr, idx_batch, m, (it_active[s] == 0) ? zero_rows[s] : 0);
+
+                        for (int b = 0; b < nb_blocks; ++b)
+                            L[s][idx_batch + b] = CheckedAdd((n > 1) ? T(0) : L[s][idx_batch + b], costs[b]);
+                    }
+                }
+
+                // their leader LAPs
+                #pragma omp for schedule(dynamic)
+                for (int s = 0; s < nb_active; ++s)
+                {
+                    if (done[s])
+                        continue;
+
+                    int& lb = active[s]->lower_bound;
+
+                    ++ it_active[s];
+
+                    T incre = LAP::SolveLeader(L[s], n, m, (int64_t)min_cost - lb);
+
+                    if (early_stop && incre == 0)
+                    {
+                        done[s] = 1;
+                        fix[s] = 0;
+                    }
+                    else
+                    {
+                        lb = CheckedAdd(lb, incre);
+                        done[s] = !(it_active[s] < it_max && lb <= min_cost) || (early_stop && options.StopIterating(incre, lb, min_cost, it_active[s], it_max));
+                        fix[s] = options.fixing && lb <= min_cost;
+                    }
+
+                    if (fix[s])
+                        Bounding::CountFixed(FixLeader(L[s], n, m, (int64_t)min_cost - lb));
+                }
+
+                // their reduced-cost fixing
+                if (options.fixing && n > 1)
+                {
+                    int nb_fixed = 0;
+
+                    #pragma omp for collapse(3) schedule(dynamic)
+                    for (int s = 0; s < nb_active; ++s)
+                    {
+                        for (int i = 0; i < n; ++i)
+                        {
+                            for (int k = 0; k < n; ++k)
+                            {
+                                if (k > i && fix[s])
+                                    nb_fixed += FixRowPair(C[s], L[s], n, m, i, k, (int64_t)min_cost - active[s]->lower_bound);
+                            }
+                        }
+                    }
+
+                    Bounding::CountFixed(nb_fixed);
+                }
+
+                #pragma omp single
+                all_done = std::all_of(done.begin(), done.end(), [](char d) { return d != 0; });
+            }
+        }
+    }
+
+    for (int s = 0, x = 0; s < nb_siblings; ++s)
+    {
+        if (x < nb_active && &siblings[s] == active[x])
+        {
+            Bounding::CountLevel(BoundLevel::Iterative, siblings[s].lower_bound > min_cost);
+            Bounding::CountIterations(siblings[s].size, it_active[x]);
+            its[s] = it_active[x++];
+        }
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> delta = t1 - t0;
+    rt += delta.count();
+}
+
+
+
+template <typename T>
+void Node<T>::WriteSegment (FILE* file, const Node* nodes, size_t count)
+{
+    // cost matrices already written in the segment
+    vector<const CostMatrix<T>*> matrices;
+
+    const uint64_t nb_nodes = count;
+    WriteBytes(file, &nb_nodes, sizeof(nb_nodes));
+
+    for (size_t x = 0; x < count; ++x)
+    {
+        const Node& node = nodes[x];
+
+        // index of the node's cost matrix in the segment, -1 for leaves
+        int idx_matrix = -1;
+
+        if (!node.costMatrix.isEmpty())
+        {
+            idx_matrix = 0;
+            while (idx_matrix < (int)matrices.size() && !matrices[idx_matrix]->sharesBuffers(node.costMatrix))
+                ++ idx_matrix;
+        }
+
+        const int header[9] = {node.size, node.lower_bound, node.branch_k, node.branch_l, idx_matrix,
+                               node.solution.cost, (int)node.solution.mapping.size(), (int)node.available.size(), node.bounded};
+
+        const vector<char> av(node.available.begin(), node.available.end());
+
+        WriteBytes(file, header, sizeof(header));
+        WriteBytes(file, node.solution.mapping.data(), node.solution.mapping.size() * sizeof(int));
+        WriteBytes(file, av.data(), av.size());
+
+        if (idx_matrix == (int)matrices.size())
+        {
+            node.costMatrix.write(file);
+            matrices.push_back(&node.costMatrix);
+        }
+    }
+}
+
+
+template <typename T>
+vector<Node<T>> Node<T>::ReadSegment (FILE* file)
+{
+    vector<CostMatrix<T>> matrices;
+
+    uint64_t nb_nodes;
+    ReadBytes(file, &nb_nodes, sizeof(nb_nodes));
+
+    vector<Node> nodes;
+    nodes.reserve(nb_nodes);
+
+    for (uint64_t x = 0; x < nb_nodes; ++x)
+    {
+        int header[9];
+        ReadBytes(file, header, sizeof(header));
+
+        Solution sol;
+        sol.cost = header[5];
+        sol.mapping.resize(header[6]);
+        ReadBytes(file, sol.mapping.data(), sol.mapping.size() * sizeof(int));
+
+        vector<char> av(header[7]);
+        ReadBytes(file, av.data(), av.size());
+
+        const int idx_matrix = header[4];
+
+        if (idx_matrix == (int)matrices.size())
+            matrices.push_back(CostMatrix<T>::Read(file));
+
+        // siblings share their parent's cost matrix again
+        CostMatrix<T> CM;
+        if (idx_matrix >= 0)
+            CM = matrices[idx_matrix].clone();
+
+        nodes.push_back(Node{sol, header[0], header[1], std::move(CM), vector<bool>(av.begin(), av.end()), header[2], header[3]});
+        nodes.back().bounded = header[8];
+    }
+
+    return nodes;
+}
+
+template class Node<int16_t>;
+template class Node<int32_t>;
+template class Node<int64_t>;
@@ -0,0 +1,158 @@
+#include "../include/search.hpp"
+
+
+Strategy ParseStrategy (const string& name)
+{
+    if (name == "dfs")
+        return Strategy::DepthFirst;
+    if (name == "best")
+        return Strategy::BestFirst;
+    if (name == "hybrid")
+        return Strategy::Hybrid;
+
+    cerr << "Error: unknown search strategy " << name << ", expected dfs, best or hybrid" << endl;
+    exit(1);
+}
+
+
+string StrategyName (Strategy strategy)
+{
+    switch (strategy)
+    {
+        case Strategy::BestFirst:
+            return "best";
+        case Strategy::Hybrid:
+            return "hybrid";
+        default:
+            return "dfs";
+    }
+}
+
+
+template <typename N>
+SearchPool<N>::SearchPool (Strategy strategy, size_t mem_limit, size_t queue_limit, int period) : strategy(strategy),
+                                                                                                 queue_limit(queue_limit),
+                                                                                                 period(std::max(1, period)),
+                                                                                                 stack(mem_limit)
+{
+}
+
+
+template <typename N>
+bool SearchPool<N>::Worse (const N& a, const N& b)
+{
+    if (a.get_lowerBound() != b.get_lowerBound())
+        return a.get_lowerBound() > b.get_lowerBound();
+
+    return a.get_size() < b.get_size();
+}
+
+
+template <typename N>
+bool SearchPool<N>::heapFull () const
+{
+    return queue_limit > 0 && Arena::get_bytes() + heap.capacity()*sizeof(N) > queue_limit;
+}
+
+
+template <typename N>
+void SearchPool<N>::pushHeap (N&& node)
+{
+    heap.push_back(std::move(node));
+    std::push_heap(heap.begin(), heap.end(), Worse);
+}
+
+
+template <typename N>
+N SearchPool<N>::popHeap ()
+{
+    std::pop_heap(heap.begin(), heap.end(), Worse);
+
+    N node = std::move(heap.back());
+    heap.pop_back();
+
+    return node;
+}
+
+
+template <typename N>
+void SearchPool<N>::push (N&& node)
+{
+    auto it = bounds.find(node.get_lowerBound());
+
+    if (it != bounds.end())
+    {
+        ++ it->second;
+    }
+    else if (!spare_bounds.empty())
+    {
+        auto entry = std::move(spare_bounds.back());
+        spare_bounds.pop_back();
+
+        entry.key() = node.get_lowerBound();
+        entry.mapped() = 1;
+        bounds.insert(std::move(entry));
+    }
+    else
+    {
+        bounds.emplace(node.get_lowerBound(), 1);
+    }
+
+    if (strategy == Strategy::BestFirst)
+    {
+        if (!heapFull())
+        {
+            pushHeap(std::move(node));
+            return;
+        }
+
+        ++ nb_fallbacks;
+    }
+
+    stack.push_back(std::move(node));
+}
+
+
+template <typename N>
+N SearchPool<N>::pop ()
+{
+    ++ nb_pops;
+
+    // the dive's open nodes join the others in the heap, as long as it has room for them
+    if (strategy == Strategy::Hybrid && nb_pops % period == 0)
+    {
+        while (!stack.empty() && !heapFull())
+        {
+            pushHeap(std::move(stack.back()));
+            stack.pop_back();
+        }
+
+        if (!stack.empty())
+            ++ nb_fallbacks;
+    }
+
+    // nodes left on the stack are explored depth-first before going back to the heap
+    N node;
+
+    if (stack.empty())
+    {
+        node = popHeap();
+    }
+    else
+    {
+        node = std::move(stack.back());
+        stack.pop_back();
+    }
+
+    auto it = bounds.find(node.get_lowerBound());
+
+    if (-- it->second == 0)
+        spare_bounds.push_back(bounds.extract(it));
+
+    return node;
+}
+
+
+template class SearchPool<Node<int16_t>>;
+template class SearchPool<Node<int32_t>>;
+template class SearchPool<Node<int64_t>>;
@@ -0,0 +1,109 @@
+#include "../include/spill.hpp"
+
+
+template <typename N>
+SpillPool<N>::~SpillPool ()
+{
+    if (file != nullptr)
+        fclose(file);
+}
+
+
+template <typename N>
+void SpillPool<N>::push_back (N&& node)
+{
+    nodes.push_back(std::move(node));
+
+    if (mem_limit > 0 && nodes.size() >= 2*MIN_SEGMENT && Arena::get_bytes() + nodes.capacity()*sizeof(N) > mem_limit)
+        spill();
+}
+
+
+template <typename N>
+N& SpillPool<N>::back ()
+{
+    if (nodes.empty())
+        reload();
+
+    return nodes.back();
+}
+
+
+template <typename N>
+void SpillPool<N>::pop_back ()
+{
+    if (nodes.empty())
+        reload();
+
+    nodes.pop_back();
+}
+
+
+template <typename N>
+vector<N> SpillPool<N>::split_bottom (size_t count)
+{
+    if (nodes.empty() && !segments.empty())
+        reload();
+
+    count = std::min(count, nodes.size());
+
+    vector<N> bottom(std::make_move_iterator(nodes.begin()), std::make_move_iterator(nodes.begin() + count));
+    nodes.erase(nodes.begin(), nodes.begin() + count);
+
+    return bottom;
+}
+
+
+template <typename N>
+void SpillPool<N>::spill ()
+{
+    if (file == nullptr)
+    {
+        file = tmpfile();
+
+        if (file == nullptr)
+        {
+            cerr << "Error: cannot create the spill file" << endl;
+            exit(1);
+        }
+    }
+
+    const size_t count = nodes.size() / 2;
+
+    // the segment overwrites the ones already reloaded
+    fseek(file, file_end, SEEK_SET);
+    N::WriteSegment(file, nodes.data(), count);
+
+    segments.push_back(file_end);
+    file_end = ftell(file);
+
+    nodes.erase(nodes.begin(), nodes.begin() + count);
+    nb_spilled += count;
+    ++ nb_spills;
+
+    // buffers only held by the spilled nodes are back in the arena, give them to the system,
+    // the per-depth ones reserved for the exploration staying warm
+    Arena::Trim();
+}
+
+
+template <typename N>
+void SpillPool<N>::reload ()
+{
+    assert(!segments.empty() && "Error: Empty pool");
+
+    file_end = segments.back();
+    segments.pop_back();
+
+    fseek(file, file_end, SEEK_SET);
+    nodes = N::ReadSegment(file);
+
+    nb_spilled -= nodes.size();
+    ++ nb_reloads;
+}
+
+
+template class SpillPool<Node<int16_t>>;
+template class SpillPool<Node<int32_t>>;
+template class SpillPool<Node<int64_t>>;
+template class SpillPool<CompactNode>;
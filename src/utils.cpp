@@ -26,7 +26,94 @@ vector<int> Arange (int n)
 }
 
 
-int idx4D (int i, int j, int k, int l, int n)
+/* index of entry (k, l) of block (i, j) in a tensor of n×m blocks, each block only storing
+   its (n-1)×(m-1) feasible entries, i.e. k != i and l != j */
+int idx4D (int i, int j, int k, int l, int n, int m)
 {
-    return n*n*n*i + n*n*j + n*k + l;
+    return ((i*m + j)*(n - 1) + k - (k > i))*(m - 1) + l - (l > j);
+}
+
+
+/* command line arguments that are not "--name=value" options */
+vector<string> PositionalArguments (int argc, char** argv)
+{
+    vector<string> args;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+
+        if (arg.rfind("--", 0) != 0)
+            args.push_back(arg);
+    }
+
+    return args;
+}
+
+
+/* value of the "--name=value" option if present, default value otherwise */
+string OptionalArgument (int argc, char** argv, const string& name, const string& default_value)
+{
+    const string prefix = "--" + name + "=";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+
+        if (arg.rfind(prefix, 0) == 0)
+            return arg.substr(prefix.size());
+    }
+
+    return default_value;
+}
+
+
+/* exits on the "--" arguments that are not a "--name=value" option of one of the names, typos included */
+void CheckOptions (int argc, char** argv, const vector<string>& names)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+
+        if (arg.rfind("--", 0) != 0)
+            continue;
+
+        const size_t eq = arg.find('=');
+        const string name = arg.substr(2, (eq == string::npos) ? string::npos : eq - 2);
+
+        if (std::find(names.begin(), names.end(), name) == names.end())
+        {
+            cerr << "Error: unknown option " << arg << ", expected one of";
+            for (const string& known : names)
+                cerr << " --" << known;
+            cerr << endl;
+            exit(1);
+        }
+
+        if (eq == string::npos)
+        {
+            cerr << "Error: option " << arg << " expects a value, as in " << arg << "=<value>" << endl;
+            exit(1);
+        }
+    }
+}
+
+
+void WriteBytes (FILE* file, const void* data, size_t bytes)
+{
+    if (bytes > 0 && fwrite(data, 1, bytes, file) != bytes)
+    {
+        cerr << "Error: cannot write " << bytes << " bytes to the spill file" << endl;
+        exit(1);
+    }
+}
+
+
+void ReadBytes (FILE* file, void* data, size_t bytes)
+{
+    if (bytes > 0 && fread(data, 1, bytes, file) != bytes)
+    {
+        cerr << "Error: cannot read " << bytes << " bytes from the spill file" << endl;
+        exit(1);
+    }
 }